@@ -8,9 +8,12 @@
 #include "SerialWrapper.h"
 
 #include "osKernel.h"
-#include "osSemaphore.h"
+#include "osEventGroup.h"
+#include "osTimer.h"
+#include "osQueueSet.h"
 #include "osQueue.h"
 #include "osIRQ.h"
+#include "osBench.h"
 
 /*==================[macros and definitions]=================================*/
 
@@ -38,16 +41,36 @@
 #define GPIO_LED_HEARBEAT   Heartbeat_Pin
 #define PORT_LED_HEARBEAT   Heartbeat_GPIO_Port
 
+#define EVENT_FALLING_BUTTON_1  (1U << 0)
+#define EVENT_RISING_BUTTON_1   (1U << 1)
+#define EVENT_FALLING_BUTTON_2  (1U << 2)
+#define EVENT_RISING_BUTTON_2   (1U << 3)
+#define EVENT_ALL_EDGES         (EVENT_FALLING_BUTTON_1 | EVENT_RISING_BUTTON_1 | EVENT_FALLING_BUTTON_2 | EVENT_RISING_BUTTON_2)
+
+#define STACK_SIZE_CONDITION    1024U   // Arma y envia los textos por serie (itoa + HAL UART)
+#define STACK_SIZE_LED          256U
+#define HEARTBEAT_PERIOD_MS     1000U
+#define QUEUE_LED_CAPACITY      4U      // Tiempos de encendido pendientes por led
+
 
 osTaskObject taskCondition;
-osTaskObject taskLedGreen;
-osTaskObject taskLedRed;
-osTaskObject taskLedYellow;
-osTaskObject taskLedBlue;
-osTaskObject taskHeartbeat;
+osTaskObject taskLeds;
+
+static uint32_t stackCondition[STACK_SIZE_CONDITION/4] OS_STACK_ALIGN;
+static uint32_t stackLeds[STACK_SIZE_LED/4] OS_STACK_ALIGN;
 
-osSemaphoreObject semaphoreLed;
+osEventGroupObject eventsButtons;
+osTimerObject timerHeartbeat;
 osQueueObject queueRed, queueGreen, queueBlue, queueYellow;
+osQueueSetObject setLeds;
+static uint64_t bufferQueueGreen[QUEUE_LED_CAPACITY];
+static uint64_t bufferQueueRed[QUEUE_LED_CAPACITY];
+static uint64_t bufferQueueYellow[QUEUE_LED_CAPACITY];
+static uint64_t bufferQueueBlue[QUEUE_LED_CAPACITY];
+#if OS_KERNEL_STATS
+osBenchQueueObject benchQueueResult;   // Se lee con el debugger
+osBenchWakeObject benchWakeResult;
+#endif
 
 /*==================[internal data definition]===============================*/
 typedef struct {
@@ -57,19 +80,30 @@ typedef struct {
     uint64_t tickRisingButton2;     // Se modifica en el flanco ascendente del boton 2.
 }dataTest;
 
+typedef struct {
+    osQueueObject *queue;           // Tiempos de encendido del led.
+    uint16_t pin;
+    GPIO_TypeDef *port;
+    osTimerObject timerOff;         // Apaga el led al vencer.
+}ledChannel;
+
+static ledChannel leds[] = {
+    { &queueGreen,  GPIO_LED_GREEN,  PORT_LED_GREEN  },
+    { &queueRed,    GPIO_LED_RED,    PORT_LED_RED    },
+    { &queueYellow, GPIO_LED_YELLOW, PORT_LED_YELLOW },
+    { &queueBlue,   GPIO_LED_BLUE,   PORT_LED_BLUE   },
+};
+
 /*==================[external data definition]===============================*/
 volatile dataTest times = {0};     // Si bien todas las tareas tiene acceso a la variable times se utilizara la API del OS para validar su funcionamiento.
-uint64_t systick = 0;
 
 /*==================[internal functions definition]==========================*/
 static char* itoa(int value, char* result, int base);
 static void buildString2Send(const uint64_t *delay, const uint64_t *time1, const uint64_t *time2);
 static void taskEvaluateCondition(void);
-static void taskGreen(void);
-static void taskRed(void);
-static void taskYellow(void);
-static void taskBlue(void);
-static void taskLedHearbeat(void);
+static void taskDriveLeds(void);
+static void timerLedOff(void *data);
+static void timerLedHearbeat(void *data);
 static void teclasCallback(void *data);
 
 
@@ -79,7 +113,7 @@ int applicationStart(void)
     //NOTE: At this point, the HW has to be initialized, please do this in the main.c file
     //		Only to simplify the process as STMCube generates autocode inside main
 
-    if (!osTaskCreate(&taskCondition, OS_HIGH_PRIORITY, taskEvaluateCondition))
+    if (!osTaskCreateEx(&taskCondition, OS_HIGH_PRIORITY, taskEvaluateCondition, stackCondition, STACK_SIZE_CONDITION, OS_TASK_FLAG_NONE))
     {
         while(1)
         {
@@ -87,7 +121,7 @@ int applicationStart(void)
         }
     }
 
-    if (!osTaskCreate(&taskLedGreen, OS_NORMAL_PRIORITY, taskGreen))
+    if (!osTaskCreateEx(&taskLeds, OS_NORMAL_PRIORITY, taskDriveLeds, stackLeds, STACK_SIZE_LED, OS_TASK_FLAG_NONE))
     {
         while(1)
         {
@@ -95,23 +129,14 @@ int applicationStart(void)
         }
     }
 
-    if (!osTaskCreate(&taskLedRed, OS_NORMAL_PRIORITY, taskRed))
-    {
-        while(1)
-        {
-            __WFI();
-        }
-    }
+    // El heartbeat es un timer periodico: no necesita tarea ni stack propios
+    osTimerInit(&timerHeartbeat, timerLedHearbeat, NULL, HEARTBEAT_PERIOD_MS * OS_SYSTICK_TICK / 1000U, true);
+    osTimerStart(&timerHeartbeat);
 
-    if (!osTaskCreate(&taskLedYellow, OS_NORMAL_PRIORITY, taskYellow))
-    {
-        while(1)
-        {
-            __WFI();
-        }
-    }
+    // Un bit por flanco: la tarea de evaluacion espera los cuatro
+    osEventGroupInit(&eventsButtons);
 
-    if (!osTaskCreate(&taskLedBlue, OS_NORMAL_PRIORITY, taskBlue))
+    if (!osQueueInit(&queueGreen, bufferQueueGreen, QUEUE_LED_CAPACITY, sizeof(uint64_t)))
     {
         while(1)
         {
@@ -119,7 +144,7 @@ int applicationStart(void)
         }
     }
 
-    if (!osTaskCreate(&taskHeartbeat, OS_LOW_PRIORITY, taskLedHearbeat))
+    if (!osQueueInit(&queueRed, bufferQueueRed, QUEUE_LED_CAPACITY, sizeof(uint64_t)))
     {
         while(1)
         {
@@ -127,18 +152,7 @@ int applicationStart(void)
         }
     }
 
-    // Semaphore is created and blocked
-    osSemaphoreInit(&semaphoreLed, 1, 1);
-
-    if (!osQueueInit(&queueGreen, sizeof(uint64_t)))
-    {
-        while(1)
-        {
-            __WFI();
-        }
-    }
-
-    if (!osQueueInit(&queueRed, sizeof(uint64_t)))
+    if (!osQueueInit(&queueYellow, bufferQueueYellow, QUEUE_LED_CAPACITY, sizeof(uint64_t)))
     {
         while(1)
         {
@@ -146,7 +160,7 @@ int applicationStart(void)
         }
     }
 
-    if (!osQueueInit(&queueYellow, sizeof(uint64_t)))
+    if (!osQueueInit(&queueBlue, bufferQueueBlue, QUEUE_LED_CAPACITY, sizeof(uint64_t)))
     {
         while(1)
         {
@@ -154,12 +168,12 @@ int applicationStart(void)
         }
     }
 
-    if (!osQueueInit(&queueBlue, sizeof(uint64_t)))
+    // Una sola tarea atiende los cuatro leds: espera en el conjunto y cada led se apaga con su timer
+    osQueueSetInit(&setLeds);
+    for (uint32_t i = 0; i < sizeof(leds)/sizeof(leds[0]); i++)
     {
-        while(1)
-        {
-            __WFI();
-        }
+        osQueueSetAddQueue(&setLeds, leds[i].queue);
+        osTimerInit(&leds[i].timerOff, timerLedOff, &leds[i], 1, false);
     }
 
     // TODO: You are able to change this section to suit your current HW
@@ -241,14 +255,15 @@ static void taskEvaluateCondition(void)
 {
     uint64_t delay = 0, time1 = 0, time2 = 0;
 
+#if OS_KERNEL_STATS
+    // Una sola vez, antes de que lleguen pulsaciones: las colas de prueba son propias del benchmark
+    osBenchQueue(&benchQueueResult);
+    osBenchWake(&benchWakeResult, EXTI0_IRQn);     // EXTI0 no la usa la placa: se dispara por software
+#endif
+
     while (1)
     {
-        osSemaphoreTake(&semaphoreLed);
-
-        if (times.tickFallingButton1 == 0 && times.tickRisingButton1 == 0 && times.tickFallingButton2 == 0 && times.tickRisingButton2 == 0)
-        {
-            continue;
-        }
+        osEventGroupWait(&eventsButtons, EVENT_ALL_EDGES, OS_EVENT_WAIT_ALL | OS_EVENT_CLEAR_ON_EXIT, NULL, OS_MAX_DELAY);
 
         // In this case, the green or red led turn on.
         if (times.tickFallingButton1 < times.tickFallingButton2)
@@ -319,90 +334,50 @@ static void taskEvaluateCondition(void)
 }
 
 /**
- * @brief Drivers the green led.
+ * @brief Drivers the four leds: waits on every led queue at once and turns the led on for the received time.
+ *        The led is turned off by its one-shot timer, so the leds stay independent without a task each.
  */
-static void taskGreen(void)
+static void taskDriveLeds(void)
 {
     uint64_t delay = 0;
+    osQueueObject* queue;
 
     while(1)
     {
-        osQueueReceive(&queueGreen, &delay, OS_MAX_DELAY);
-        gpioSetLevel(GPIO_LED_GREEN, (uint32_t)PORT_LED_GREEN, true);
-        osDelay((uint32_t)delay);
-        gpioSetLevel(GPIO_LED_GREEN, (uint32_t)PORT_LED_GREEN, false);
-        delay = 0;
-    }
-}
-
-/**
- * @brief Drivers the red led.
- */
-static void taskRed(void)
-{
-    uint64_t delay = 0;
-
-    while(1)
-    {
-        osQueueReceive(&queueRed, &delay, OS_MAX_DELAY);
-        gpioSetLevel(GPIO_LED_RED, (uint32_t)PORT_LED_RED, true);
-        osDelay((uint32_t)delay);
-        gpioSetLevel(GPIO_LED_RED, (uint32_t)PORT_LED_RED, false);
-        delay = 0;
-    }
-}
+        osSelect(&setLeds, (void **)&queue, OS_MAX_DELAY);
 
-/**
- * @brief Drivers the yellow led.
- */
-static void taskYellow(void)
-{
-    uint64_t delay = 0;
+        for (uint32_t i = 0; i < sizeof(leds)/sizeof(leds[0]); i++)
+        {
+            if (leds[i].queue != queue || osQueueReceive(queue, &delay, 0) != OS_OK || delay == 0) continue;
 
-    while(1)
-    {
-        osQueueReceive(&queueYellow, &delay, OS_MAX_DELAY);
-        gpioSetLevel(GPIO_LED_YELLOW, (uint32_t)PORT_LED_YELLOW, true);
-        osDelay((uint32_t)delay);
-        gpioSetLevel(GPIO_LED_YELLOW, (uint32_t)PORT_LED_YELLOW, false);
-        delay = 0;
+            // Si el led ya estaba encendido, el nuevo tiempo se cuenta desde ahora
+            gpioSetLevel(leds[i].pin, (uint32_t)leds[i].port, true);
+            osTimerSetPeriod(&leds[i].timerOff, (uint32_t)delay);
+            osTimerReset(&leds[i].timerOff);
+        }
     }
 }
 
 /**
- * @brief Drivers the blue led.
+ * @brief Turns off the led of the channel whose timer expired.
  */
-static void taskBlue(void)
+static void timerLedOff(void *data)
 {
-    uint64_t delay = 0;
+    ledChannel *led = (ledChannel *)data;
 
-    while(1)
-    {
-        osQueueReceive(&queueBlue, &delay, OS_MAX_DELAY);
-        gpioSetLevel(GPIO_LED_BLUE, (uint32_t)PORT_LED_BLUE, true);
-        osDelay((uint32_t)delay);
-        gpioSetLevel(GPIO_LED_BLUE, (uint32_t)PORT_LED_BLUE, false);
-        delay = 0;
-    }
+    gpioSetLevel(led->pin, (uint32_t)led->port, false);
 }
 
 /**
- * @brief Drivers the heartbeat led.
+ * @brief Drivers the heartbeat led, toggling it on every expiry of timerHeartbeat.
  */
-static void taskLedHearbeat(void)
+static void timerLedHearbeat(void *data)
 {
-    while(1)
-    {
-        osDelay(1000);
-        gpioSetLevel(GPIO_LED_HEARBEAT, (uint32_t)PORT_LED_HEARBEAT, true);
-        osDelay(1000);
-        gpioSetLevel(GPIO_LED_HEARBEAT, (uint32_t)PORT_LED_HEARBEAT, false);
-    }
-}
+    static bool level = false;
 
-void osSysTickHook(void)
-{
-    systick++;
+    (void)data;
+    level = !level;
+    gpioSetLevel(GPIO_LED_HEARBEAT, (uint32_t)PORT_LED_HEARBEAT, level);
 }
 
 /**
@@ -420,13 +395,16 @@ void teclasCallback(void *data)
       if (gpioGetLevel(GPIO_BUTTON_1, (uint32_t)PORT_BUTTON_1))
       {
           // Rising edge detected.
-          time->tickRisingButton1 = systick;
+          time->tickRisingButton1 = osGetTickCount();
+          osEventGroupSet(&eventsButtons, EVENT_RISING_BUTTON_1);
       }
       else
       {
           // Falling edge detected.
-          time->tickFallingButton1 = systick;
+          time->tickFallingButton1 = osGetTickCount();
           time->tickRisingButton1 = 0;
+          osEventGroupClear(&eventsButtons, EVENT_RISING_BUTTON_1);
+          osEventGroupSet(&eventsButtons, EVENT_FALLING_BUTTON_1);
       }
     }
 
@@ -437,18 +415,16 @@ void teclasCallback(void *data)
       if (gpioGetLevel(GPIO_BUTTON_2, (uint32_t)PORT_BUTTON_2))
       {
           // Rising edge detected.
-          time->tickRisingButton2 = systick;
+          time->tickRisingButton2 = osGetTickCount();
+          osEventGroupSet(&eventsButtons, EVENT_RISING_BUTTON_2);
       }
       else
       {
           // Falling edge detected.
-          time->tickFallingButton2 = systick;
+          time->tickFallingButton2 = osGetTickCount();
           time->tickRisingButton2 = 0;
+          osEventGroupClear(&eventsButtons, EVENT_RISING_BUTTON_2);
+          osEventGroupSet(&eventsButtons, EVENT_FALLING_BUTTON_2);
       }
     }
-
-    if (time->tickFallingButton1 != 0 && time->tickRisingButton1 != 0 && time->tickFallingButton2 != 0 && time->tickRisingButton2 != 0)
-    {
-        osSemaphoreGive(&semaphoreLed);
-    }
 }
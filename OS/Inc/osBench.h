@@ -0,0 +1,68 @@
+#ifndef INC_OSBENCH_H
+#define INC_OSBENCH_H
+
+#include <stdint.h>
+
+#include "osIRQ.h"
+
+/**
+ * Mediciones de ciclos con el DWT de las primitivas del kernel que tienen alternativas, para decidir
+ * con numeros cual conviene. Solo existe con OS_KERNEL_STATS en 1.
+ */
+
+#define OS_BENCH_ITERATIONS     32U         // Repeticiones de cada medicion; se queda con la mas rapida
+#define OS_BENCH_SIZES          3U          // Tamaños de mensaje medidos: 8, 64 y 512 bytes
+#define OS_BENCH_MAX_SIZE       512U
+#define OS_BENCH_BATCH          8U          // Elementos de 8 bytes por lote en la comparacion de lotes
+
+typedef struct
+{
+	uint32_t size[OS_BENCH_SIZES];			// Bytes por mensaje de cada medicion
+	uint32_t copyCycles[OS_BENCH_SIZES];	// Ciclos por mensaje con osQueueSend/osQueueReceive
+	uint32_t zeroCopyCycles[OS_BENCH_SIZES];// Ciclos por mensaje con osQueueAllocBlock/CommitBlock/ReceiveBlock/ReleaseBlock
+	uint32_t perItemCycles;					// Ciclos por elemento enviando y recibiendo OS_BENCH_BATCH de a uno
+	uint32_t batchCycles;					// Ciclos por elemento con un osQueueSendBatch y un osQueueReceiveBatch
+}osBenchQueueObject;
+
+typedef struct
+{
+	uint32_t semaphoreCycles;				// Ciclos desde el handler de la IRQ hasta que corre la tarea, con osSemaphoreGive
+	uint32_t notifyCycles;					// Idem con osTaskNotify
+	uint32_t semaphoreBytes;				// RAM de cada semaforo usado como señal
+	uint32_t notifyBytes;					// RAM de la notificacion, que ya reserva cada TCB: no suma por señal
+}osBenchWakeObject;
+
+/**
+ * @brief Mide el costo por mensaje de una cola que copia contra una cola sin copia, y el de enviar y recibir
+ *        de a un elemento contra hacerlo en lotes.
+ *
+ * Cada mensaje se escribe una vez (en el buffer del productor o directo en el bloque), se envia, se recibe
+ * y se lee su primer byte. Corre en la tarea que la llama, sin otras tareas esperando: mide el camino sin
+ * cambios de contexto. Cada valor es el minimo de OS_BENCH_ITERATIONS, asi no cuenta las iteraciones que
+ * interrumpio el tick, y ya tiene descontado el costo de leer el contador.
+ *
+ * Sin tareas esperando, la comparacion de lotes solo refleja las secciones criticas y llamadas que se
+ * ahorran; con receptores bloqueados el lote ademas evita un despertar y un PendSV por elemento.
+ *
+ * @param result Recibe los ciclos por mensaje.
+ */
+void osBenchQueue(osBenchQueueObject* result);
+/**
+ * @brief Mide cuanto tarda en correr una tarea despertada desde una ISR con un semaforo contra hacerlo con
+ *        una notificacion directa, y cuanta RAM usa cada señal.
+ *
+ * La tarea que llama se bloquea en el semaforo (o en osTaskNotifyWait) y la despierta el handler de irq,
+ * que se dispara por software con NVIC_SetPendingIRQ. La IRQ se deja pendiente con las interrupciones
+ * deshabilitadas, asi entra justo cuando la tarea ya quedo bloqueada. Cada valor va desde la primera
+ * instruccion del handler hasta que la tarea vuelve de la espera: incluye el give o el notify, el
+ * scheduler y el PendSV. Es el minimo de OS_BENCH_ITERATIONS, sin el costo de leer el contador.
+ *
+ * Se llama desde una tarea, con el SO corriendo.
+ *
+ * @param irq Interrupcion libre: se registra durante la medicion y se libera al terminar.
+ * @param result Recibe los ciclos, o UINT32_MAX si no se pudo medir (irq ocupada o fuera de una tarea).
+ */
+void osBenchWake(osBenchWakeObject* result, osIRQnType irq);
+
+
+#endif // INC_OSBENCH_H
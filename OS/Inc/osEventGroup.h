@@ -0,0 +1,53 @@
+#ifndef INC_OSEVENTGROUP_H
+#define INC_OSEVENTGROUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+
+
+typedef enum{
+    OS_EVENT_WAIT_ANY       = 0x00,     // Alcanza con uno de los bits pedidos
+    OS_EVENT_WAIT_ALL       = 0x01,     // Tienen que estar todos los bits pedidos
+    OS_EVENT_CLEAR_ON_EXIT  = 0x02,     // Al cumplirse la espera se borran los bits pedidos
+}osEventWaitOptionType;
+
+typedef struct
+{
+	volatile uint32_t flags;	// Un bit por evento
+	osTaskListObject waitList;	// Tareas esperando una combinacion de bits
+
+
+}osEventGroupObject;
+
+/**
+ * @brief Inicializa un grupo de eventos con todos los bits en cero.
+ */
+void osEventGroupInit(osEventGroupObject* group);
+/**
+ * @brief Pone en 1 los bits indicados y despierta a todas las tareas cuya espera se cumple. Se puede llamar desde una ISR.
+ * @return Bits del grupo despues de despertar (sin los que borraron las esperas con OS_EVENT_CLEAR_ON_EXIT).
+ */
+uint32_t osEventGroupSet(osEventGroupObject* group, const uint32_t bits);
+/**
+ * @brief Pone en 0 los bits indicados. Se puede llamar desde una ISR.
+ * @return Bits del grupo antes de borrarlos.
+ */
+uint32_t osEventGroupClear(osEventGroupObject* group, const uint32_t bits);
+/**
+ * @brief Devuelve los bits actuales del grupo.
+ */
+uint32_t osEventGroupGet(osEventGroupObject* group);
+/**
+ * @brief Espera que se activen uno (OS_EVENT_WAIT_ANY) o todos (OS_EVENT_WAIT_ALL) los bits de mask.
+ * @param mask Bits esperados, distinto de cero.
+ * @param options Combinacion de osEventWaitOptionType.
+ * @param flags Si no es NULL recibe los bits del grupo al cumplirse la espera (o al vencer el timeout).
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK (no se cumple y no se puede esperar) u OS_ERROR si mask es cero.
+ */
+osResultType osEventGroupWait(osEventGroupObject* group, const uint32_t mask, const uint32_t options, uint32_t* flags, const uint32_t timeout);
+
+
+#endif // INC_OSEVENTGROUP_H
@@ -6,11 +6,21 @@
  */
 
 #ifndef INC_OSIRQ_H_
-#define INC_OSIRQ_H__
+#define INC_OSIRQ_H_
 
 #include <stdbool.h>
 #include "stm32f429.h"
 
+#ifndef OS_IRQ_WORKER_PRIORITY
+#define OS_IRQ_WORKER_PRIORITY      OS_VERYHIGH_PRIORITY    /* Bottom halves run before any application task */
+#endif
+#ifndef OS_IRQ_WORKER_STACK_SIZE
+#define OS_IRQ_WORKER_STACK_SIZE    512U                    /* Stack shared by every bottom half */
+#endif
+#ifndef OS_IRQ_DEFER_QUEUE_SIZE
+#define OS_IRQ_DEFER_QUEUE_SIZE     16U                     /* Pending bottom halves, power of two */
+#endif
+
 extern osIRQVector irqVector[IRQ_NUMBER];
 
 
@@ -34,4 +44,30 @@ bool osRegisterIRQ(osIRQnType irqType, IRQHandler function, void *data);
  */
 bool osUnregisterIRQ(osIRQnType irqType);
 
+/**
+ * @brief Queues a bottom half to be run by the IRQ worker task.
+ *
+ * Meant to be called from the top half registered with osRegisterIRQ: the top half only acknowledges
+ * the hardware and defers the heavy processing, which then runs in thread mode at OS_IRQ_WORKER_PRIORITY.
+ * Requires OS_USE_IRQ_WORKER set to 1; otherwise there is no worker and it always returns false.
+ *
+ * Only the slot reservation is lock-free (LDREX/STREX). Waking the worker goes through osTaskNotify, which
+ * masks every interrupt (cpsid i) while it updates the ready list. It can therefore be called from nested
+ * interrupts of any configurable priority, but not from NMI or fault handlers, and it adds that short
+ * masked section to the latency of every other interrupt.
+ *
+ * @param[in]	function    Bottom half to be executed by the worker task.
+ * @param[in]	data		Data passed to the bottom half.
+ *
+ * @return Returns false if the queue is full (the bottom half is dropped), otherwise true.
+ */
+bool osIRQDefer(IRQHandler function, void *data);
+
+/**
+ * @brief Creates the IRQ worker task. Called by osStart() when OS_USE_IRQ_WORKER is 1.
+ *
+ * @return Returns false if there is no room for the task, otherwise true.
+ */
+bool osIRQWorkerInit(void);
+
 #endif // INC_OSIRQ_H_
@@ -18,20 +18,46 @@ extern "C" {
 #include "core_cm4.h"
 #include "cmsis_gcc.h"
 
+#include "osTaskList.h"
 #include "osSemaphore.h"
 #include "osQueue.h"
+#include "osMutex.h"
+#include "osEventGroup.h"
+#include "osTimer.h"
+#include "osRing.h"
+#include "osQueueSet.h"
+#include "osStreamBuffer.h"
+#include "osMessageBuffer.h"
+#include "osPool.h"
 
 /* Exported macro ------------------------------------------------------------*/
 #define MAX_TASKS            8U
-#define MAX_STACK_SIZE       256U
-#define MAX_PRIORITY         4U          // MAX_STACK_SIZE Defines the maximum amount of priority.
+#define MAX_STACK_SIZE       256U        // Stack de las tareas creadas con osTaskCreate
+#define MIN_STACK_SIZE       128U        // Minimo aceptado por osTaskCreateEx (stack frame inicial y margen)
+#define FPU_CONTEXT_SIZE     136U        // Extra de una tarea OS_TASK_FLAG_FPU: S0-S15, FPSCR y reservado (hardware) + S16-S31
+#ifndef OS_STACK_POOL_TASKS
+#define OS_STACK_POOL_TASKS  0U          // Stacks de MAX_STACK_SIZE reservados para osTaskCreate; con 0 solo se usa osTaskCreateEx
+#endif
+#define OS_IDLE_STACK_SIZE   MAX_STACK_SIZE
+#define OS_STACK_ALIGN       __attribute__((aligned(8)))    // AAPCS: el stack debe estar alineado a 8 bytes
+#define MAX_PRIORITY         4U          // Cantidad de prioridades de usuario; MAX_PRIORITY queda reservada para idle
 #define MAX_TASK_NAME_CHAR   10
 #define STACK_FRAME_SIZE     17
 #define OS_SYSTICK_TICK         1000        // In milliseconds
+#ifndef OS_KERNEL_STATS
+#define OS_KERNEL_STATS         0           // 1: mide con el DWT los ciclos consumidos por el scheduler
+#endif
+#define OS_USE_TICKLESS_IDLE    1           // 1: la idle detiene el tick periodico mientras no hay tareas listas
+#define OS_TICKLESS_MIN_IDLE_TICKS  2       // Ticks minimos de espera para que convenga reprogramar el SysTick
+#define OS_FPU_STRICT           0           // 1: llama a osErrorHook si una tarea sin OS_TASK_FLAG_FPU deja contexto de FPU
+#define OS_USE_TIMERS           1           // 1: osStart crea la tarea de timers por software (ocupa un lugar de MAX_TASKS)
+#ifndef OS_USE_IRQ_WORKER
+#define OS_USE_IRQ_WORKER       0           // 1: osStart crea la tarea que ejecuta las mitades diferidas de osIRQDefer
+#endif
 
 /* Bits positions on Stack Frame */
 #define XPSR_VALUE              1 << 24     // xPSR thumb = 1
-#define EXEC_RETURN_VALUE       0xFFFFFFF9  // EXEC_RETURN value. Return to thread mode with MSP, not use FPU
+#define EXEC_RETURN_VALUE       0xFFFFFFFD  // EXEC_RETURN value. Return to thread mode with PSP, not use FPU
 #define XPSR_REG_POSITION       1
 #define PC_REG_POSTION          2
 #define LR_REG_POSTION          3
@@ -69,35 +95,97 @@ typedef enum{
 
 
 typedef enum{
-    OS_VERYHIGH_PRIORITY    = 0,                // Highest Priority
-    OS_HIGH_PRIORITY    	= 1,
-    OS_NORMAL_PRIORITY    	= 2,
-    OS_LOW_PRIORITY    		= 3,                // Less Priority
-}osPriorityType;
+    OS_TASK_FLAG_NONE   = 0x00,
+    OS_TASK_FLAG_FPU    = 0x01,                 // La tarea usa la FPU: se le exige stack para el contexto extendido
+}osTaskFlagType;
 
 
-typedef struct{
-    uint32_t memory[MAX_STACK_SIZE/4];    // Memory Size
+typedef enum{
+    OS_NOTIFY_NO_ACTION     = 0,                // Solo despierta a la tarea, no modifica su valor
+    OS_NOTIFY_SET_BITS      = 1,                // OR del valor con el de la tarea (como un grupo de eventos propio)
+    OS_NOTIFY_INCREMENT     = 2,                // Suma uno (como un semaforo contador propio)
+    OS_NOTIFY_OVERWRITE     = 3,                // Reemplaza el valor (como un buzon de una palabra)
+}osNotifyActionType;
+
+
+typedef enum{
+    OS_NOTIFY_STATE_NONE    = 0,                // Sin notificacion pendiente
+    OS_NOTIFY_STATE_PENDING = 1,                // La notificaron y todavia no la leyo
+    OS_NOTIFY_STATE_WAITING = 2,                // Bloqueada en osTaskNotifyWait
+}osNotifyStateType;
+
+
+typedef struct osTaskObject{
+    uint32_t* taskStackBase;                // Inicio del stack de la tarea (direccion mas baja)
+    uint32_t taskStackSize;                 // Tamaño del stack en bytes
     uint32_t taskStackPointer;                   // Store the task SP
     void* taskEntryPoint;                   // Entry point for the task
     osTaskStatusType taskExecStatus;        // Task current execution status
-    osPriorityType taskPriority;       // Task priority (Not in used for now)
+    osPriorityType taskPriority;       // Task priority, indexa la cola de listas del scheduler
+    osPriorityType taskBasePriority;        // Prioridad asignada al crearla; taskPriority puede subir por un mutex
     uint32_t taskID;                             // Task ID
+    uint32_t taskFlags;                     // Combinacion de osTaskFlagType
+    uint32_t taskFpuSwitches;               // Veces que se la desalojo con contexto de FPU (la uso desde su ultimo turno)
     char* taskName[MAX_TASK_NAME_CHAR];  // Task name in string
-    uint32_t taskTickCounter;
-    //---queue
-    bool  taskBlockedByFullQueue;
-    bool  taskBlockedByEmptyQueue;
-    osQueueObject *queueFull;
-    osQueueObject *queueEmpty;
-    //---semaphore
-    bool  semaphoreBlocked;
-    osSemaphoreObject *semaphoreTask;
+    uint32_t taskWakeTick;                  // Tick absoluto en el que vence el osDelay
+    //---cola de listas de su prioridad, o lista de espera del semaforo/cola que la bloquea
+    struct osTaskObject* taskNext;
+    struct osTaskObject* taskPrev;
+    osTaskListObject* taskWaitList;         // Lista de espera en la que esta bloqueada, NULL si no espera un objeto
+    uint32_t taskWaitValue;                 // Lo que pide al objeto que espera (p. ej. unidades de un semaforo)
+    uint32_t taskWaitOptions;               // Como lo pide (p. ej. osEventWaitOptionType de un grupo de eventos)
+    osResultType taskWaitResult;            // OS_OK si la desperto el objeto, OS_TIMEOUT si vencio la espera
+    uint32_t taskNotifyValue;               // Palabra de notificacion directa
+    osNotifyStateType taskNotifyState;
+    struct osMutexObject* taskWaitMutex;    // Mutex por el que esta bloqueada, para propagar la herencia de prioridad
+    struct osMutexObject* taskMutexList;    // Mutex que posee, el ultimo tomado primero
+    //---lista de tareas dormidas, ordenada por taskWakeTick
+    struct osTaskObject* delayNext;
+    struct osTaskObject* delayPrev;
 
 }osTaskObject;
 
 
+typedef struct{
+    uint32_t schedulerLastCycles;           // Ciclos del ultimo llamado al scheduler
+    uint32_t schedulerMaxCycles;            // Peor caso medido
+    uint32_t schedulerScanLastCycles;       // Ciclos del recorrido lineal de referencia sobre el mismo estado
+    uint32_t schedulerScanMaxCycles;        // Peor caso medido
+    uint32_t tickLastCycles;                // Ciclos del ultimo SysTick_Handler
+    uint32_t tickMaxCycles;                 // Peor caso medido
+    uint32_t tickIdleMaxCycles[MAX_TASKS];  // Peor SysTick_Handler sin vencimientos, segun cuantas tareas dormian
+    uint32_t wakeLatencyLastCycles;         // Ciclos desde que se despierta una tarea de mayor prioridad hasta que corre
+    uint32_t wakeLatencyMaxCycles;          // Peor caso medido
+    uint32_t switchSaveCycles;              // Ciclos desde la entrada a PendSV hasta getNextContext, contexto entero
+    uint32_t switchSaveFpuCycles;           // Idem cuando ademas se guardo S16-S31 (y el estado diferido de S0-S15)
+}osKernelStatsObject;
+
+
+#if OS_STACK_POOL_TASKS > 0
+/**
+ * @brief Crea una tarea con un stack de MAX_STACK_SIZE tomado del pool del kernel.
+ *
+ * El pool es opcional: hay que definir OS_STACK_POOL_TASKS con la cantidad de tareas que lo usan.
+ * Con el valor por defecto (0) no reserva memoria y osTaskCreate no existe: usar osTaskCreateEx.
+ *
+ * @param handler Objeto de la tarea.
+ * @param priority Prioridad de la tarea.
+ * @param taskCallback Funcion de entrada de la tarea.
+ * @return true si se creo, false si los parametros son invalidos o no hay lugar.
+ */
 bool osTaskCreate(osTaskObject* handler, osPriorityType priority, void* taskCallback);
+#endif
+/**
+ * @brief Crea una tarea con un stack provisto por el llamador.
+ * @param handler Objeto de la tarea.
+ * @param priority Prioridad de la tarea.
+ * @param taskCallback Funcion de entrada de la tarea.
+ * @param stack Buffer del stack, alineado a 8 bytes (ver OS_STACK_ALIGN).
+ * @param stackSize Tamaño del buffer en bytes, multiplo de 8 y al menos MIN_STACK_SIZE (mas FPU_CONTEXT_SIZE con OS_TASK_FLAG_FPU).
+ * @param flags Combinacion de osTaskFlagType.
+ * @return true si se creo, false si los parametros son invalidos o no hay lugar.
+ */
+bool osTaskCreateEx(osTaskObject* handler, osPriorityType priority, void* taskCallback, uint32_t* stack, uint32_t stackSize, uint32_t flags);
 /**
  * @brief Función de inicio del sistema operativo.
  */
@@ -107,12 +195,40 @@ void osStart(void);
  * @return Puntero al objeto de tarea de la tarea actual.
  */
 osTaskObject* getTask(void);
+/**
+ * @brief Tarea en ejecucion que puede bloquearse.
+ * @return La tarea actual, o NULL si el SO no arranco o se llama desde un handler de interrupcion.
+ */
+osTaskObject* osGetRunningTask(void);
 //void osCallSche(void);
 /**
  * @brief Función para bloquear una tarea durante un número de ticks.
- * @param tick Número de ticks para bloquear la tarea.
+ * @param tick Número de ticks para bloquear la tarea, hasta OS_MAX_TIMEOUT (los valores mayores se limitan).
  */
 void osDelay(const uint32_t tick);
+/**
+ * @brief Notifica directamente a una tarea, sin objeto intermedio. Se puede llamar desde una ISR.
+ * @param task Tarea a notificar.
+ * @param value Valor a aplicar segun action.
+ * @param action Como se combina value con la palabra de notificacion de la tarea.
+ */
+void osTaskNotify(osTaskObject* task, const uint32_t value, const osNotifyActionType action);
+/**
+ * @brief Espera una notificacion para la tarea actual.
+ * @param clearOnEntry Bits que se borran de la palabra si no habia una notificacion pendiente.
+ * @param clearOnExit Bits que se borran al recibir la notificacion (0xFFFFFFFF la vuelve a cero).
+ * @param value Si no es NULL recibe la palabra antes de aplicar clearOnExit.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK (sin notificacion y timeout 0) u OS_ERROR fuera de una tarea.
+ */
+osResultType osTaskNotifyWait(const uint32_t clearOnEntry, const uint32_t clearOnExit, uint32_t* value, const uint32_t timeout);
+/**
+ * @brief Como osTaskNotifyWait, pero espera hasta un tick absoluto: el vencimiento no se corre si la tarea
+ *        tarda en llegar a la llamada.
+ * @param wakeTick Valor de osGetTickCount() en el que vence, a lo sumo OS_MAX_TIMEOUT ticks en el futuro.
+ * @return OS_OK, OS_TIMEOUT (tambien si wakeTick ya paso) u OS_ERROR fuera de una tarea.
+ */
+osResultType osTaskNotifyWaitUntil(const uint32_t clearOnEntry, const uint32_t clearOnExit, uint32_t* value, const uint32_t wakeTick);
 /**
  * @brief Función para obtener el estado del sistema operativo.
  * @return Estado actual del sistema operativo.
@@ -125,32 +241,152 @@ OsStatus osGetStatus(void); //---
 void osSetStatus(OsStatus s);//---
 //---CR
 /**
- * @brief Bloquea una tarea por una cola.
+ * @brief Bloquea la tarea actual en la lista de espera de una cola.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ *
  * @param queue Puntero a la cola.
- * @param sender Indica si la tarea fue bloqueada por cola llena (0) o cola vacía (1).
+ * @param sender 1 si la tarea envia y espera lugar (cola llena), 0 si recibe y espera datos (cola vacía).
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si la desperto la cola, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si no se puede bloquear.
  */
-void blockTaskFromQueue(osQueueObject *queue, uint8_t sender);
+osResultType blockTaskFromQueue(osQueueObject *queue, uint8_t sender, uint32_t timeout);
 
 /**
- * @brief Comprueba y desbloquea tareas bloqueadas por cola.
+ * @brief Despierta a la primera tarea que espera en la cola.
  * @param queue Puntero a la cola.
- * @param sender Indica si la tarea fue bloqueada por cola llena (0) o cola vacía (1).
+ * @param sender 1 si el llamador acaba de enviar (despierta a un receptor), 0 si acaba de recibir (despierta a un emisor).
  */
 void checkBlockedTaskFromQueue(osQueueObject *queue, uint8_t sender);
 
+/**
+ * @brief Despierta hasta count tareas que esperan en la cola, con un solo pedido de cambio de contexto.
+ * @param queue Puntero a la cola.
+ * @param sender 1 si el llamador acaba de enviar (despierta receptores), 0 si acaba de recibir (despierta emisores).
+ * @param count Elementos que se movieron: no tiene sentido despertar a mas tareas que esas.
+ */
+void checkBlockedTaskFromQueueN(osQueueObject *queue, uint8_t sender, uint32_t count);
+
 /**
  * @brief Bloquea una tarea por un semáforo.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ *
  * @param semaphore Puntero al semáforo.
+ * @param count Unidades que espera tomar.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si recibio las unidades, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si no se puede bloquear.
  */
 
-void blockTaskFromSem(osSemaphoreObject* semaphore);
+osResultType blockTaskFromSem(osSemaphoreObject* semaphore, uint32_t count, uint32_t timeout);
 
 /**
- * @brief Comprueba y desbloquea tareas bloqueadas por semáforo.
+ * @brief Despierta a la primera tarea de la lista de espera del semáforo.
  * @param semaphore Puntero al semáforo.
  */
 void checkBlockedTaskFromSem(osSemaphoreObject *semaphore);
 
+/**
+ * @brief Bloquea la tarea actual hasta que el mutex se la entregue, prestandole su prioridad al dueño.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ * Si el dueño esta a su vez bloqueado por otro mutex la herencia sigue la cadena de dueños.
+ *
+ * @param mutex Puntero al mutex.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si el mutex ya es suyo, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si no se puede bloquear.
+ */
+osResultType blockTaskFromMutex(osMutexObject* mutex, uint32_t timeout);
+
+/**
+ * @brief Entrega el mutex libre a la tarea de mayor prioridad que lo espera y la despierta.
+ * @param mutex Puntero al mutex, sin dueño.
+ */
+void checkBlockedTaskFromMutex(osMutexObject* mutex);
+
+/**
+ * @brief Recalcula la prioridad de una tarea: la base, o la mas alta entre los techos y las tareas
+ *        que esperan los mutex que posee.
+ * @param task Tarea a actualizar.
+ */
+void updateTaskMutexPriority(osTaskObject* task);
+
+/**
+ * @brief Bloquea la tarea actual hasta que el grupo cumpla su espera o venza el timeout.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ *
+ * @param group Puntero al grupo de eventos.
+ * @param mask Bits esperados.
+ * @param options Combinacion de osEventWaitOptionType.
+ * @param flags Recibe los bits que cumplieron la espera, o los actuales si no se cumplio.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si se cumplio la espera, OS_TIMEOUT si vencio, OS_WOULD_BLOCK si no se puede bloquear.
+ */
+osResultType blockTaskFromEventGroup(osEventGroupObject* group, uint32_t mask, uint32_t options, uint32_t* flags, uint32_t timeout);
+
+/**
+ * @brief Despierta a todas las tareas cuya espera cumplen los bits actuales del grupo y borra los
+ *        bits de las que usan OS_EVENT_CLEAR_ON_EXIT.
+ * @param group Puntero al grupo de eventos.
+ */
+void checkBlockedTaskFromEventGroup(osEventGroupObject* group);
+
+/**
+ * @brief Bloquea la tarea actual hasta que algun miembro del conjunto este listo o venza el timeout.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ *
+ * @param set Puntero al conjunto.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si la desperto un miembro, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si no se puede bloquear.
+ */
+osResultType blockTaskFromQueueSet(osQueueSetObject* set, uint32_t timeout);
+
+/**
+ * @brief Despierta a la primera tarea que espera el conjunto.
+ * @param set Puntero al conjunto.
+ */
+void checkBlockedTaskFromQueueSet(osQueueSetObject* set);
+
+/**
+ * @brief Bloquea la tarea actual en un buffer de mensajes.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ *
+ * @param buffer Puntero al buffer de mensajes.
+ * @param sender 1 si la tarea envia y espera lugar, 0 si recibe y espera un mensaje.
+ * @param needed Bytes que necesita el emisor (mensaje y prefijo); se ignora en el receptor.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si la desperto el buffer, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si no se puede bloquear.
+ */
+osResultType blockTaskFromMessageBuffer(osMessageBufferObject* buffer, uint8_t sender, uint32_t needed, uint32_t timeout);
+
+/**
+ * @brief Despierta a las tareas que esperan el buffer de mensajes.
+ * @param buffer Puntero al buffer de mensajes.
+ * @param sender 1 si el llamador acaba de enviar (despierta a un receptor), 0 si acaba de recibir (despierta,
+ *        en orden, a los emisores cuyos mensajes entran en el lugar libre).
+ */
+void checkBlockedTaskFromMessageBuffer(osMessageBufferObject* buffer, uint8_t sender);
+
+/**
+ * @brief Bloquea la tarea actual hasta que el pool tenga un bloque libre.
+ *
+ * Se llama dentro de una sección crítica: la libera mientras la tarea espera y la vuelve a tomar antes de retornar.
+ *
+ * @param pool Puntero al pool.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), u OS_MAX_DELAY.
+ * @return OS_OK si la desperto el pool, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si no se puede bloquear.
+ */
+osResultType blockTaskFromPool(osPoolObject* pool, uint32_t timeout);
+
+/**
+ * @brief Despierta a una tarea que espera un bloque del pool, si hay alguna.
+ * @param pool Puntero al pool.
+ */
+void checkBlockedTaskFromPool(osPoolObject* pool);
+
 //----
 
 /**
@@ -167,6 +403,34 @@ void osExitCriticalSection(void);
 
 void osSysTickHook(void);
 
+/**
+ * @brief Devuelve la cantidad de ticks transcurridos desde osStart(), incluidos los dormidos en modo tickless.
+ * @return Ticks del sistema.
+ */
+uint32_t osGetTickCount(void);
+
+/**
+ * @brief Ticks que le quedan a una espera que empezo en startTick.
+ * @param startTick Valor de osGetTickCount() al comenzar la espera.
+ * @param timeout Timeout total, u OS_MAX_DELAY.
+ * @return Ticks restantes (0 si vencio), u OS_MAX_DELAY si la espera es infinita.
+ */
+uint32_t osGetRemainingTicks(uint32_t startTick, uint32_t timeout);
+
+/**
+ * @brief Duerme sin tick periodico hasta el proximo vencimiento de osDelay (o hasta una interrupcion).
+ *
+ * La llama la idle cuando OS_USE_TICKLESS_IDLE es 1. Si hay otra tarea lista o el proximo vencimiento
+ * esta a menos de OS_TICKLESS_MIN_IDLE_TICKS solo ejecuta WFI.
+ */
+void osTicklessIdle(void);
+
+/**
+ * @brief Devuelve las mediciones de ciclos del kernel (requiere OS_KERNEL_STATS en 1).
+ * @return Puntero a las estadisticas del kernel.
+ */
+const osKernelStatsObject* osGetKernelStats(void);
+
 void osYield(void);//===Aqui
 
 
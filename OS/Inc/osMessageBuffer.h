@@ -0,0 +1,55 @@
+#ifndef INC_OSMESSAGEBUFFER_H
+#define INC_OSMESSAGEBUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+
+#define OS_MESSAGE_HEADER_SIZE  sizeof(uint16_t)    // Prefijo de largo de cada mensaje
+#define OS_MESSAGE_MAX_LENGTH   0xFFFFU             // Largo maximo que entra en el prefijo
+
+typedef struct
+{
+	uint8_t *data;					// Buffer de size bytes provisto por el llamador
+	uint32_t size;
+	uint32_t head;					// Proximo byte a escribir
+	uint32_t tail;					// Comienzo del proximo mensaje
+	uint32_t used;					// Bytes ocupados, prefijos incluidos
+	osTaskListObject waitSend;		// Tareas esperando lugar para su mensaje (taskWaitValue: bytes que necesitan)
+	osTaskListObject waitReceive;	// Tareas esperando un mensaje
+
+
+}osMessageBufferObject;
+
+/**
+ * @brief Inicializa un buffer de mensajes vacio. Los mensajes se guardan uno detras de otro, cada uno con su
+ *        largo adelante, sin relleno hasta un tamaño fijo.
+ * @param storage Buffer de size bytes.
+ * @param size Tamaño del buffer; un mensaje ocupa su largo mas OS_MESSAGE_HEADER_SIZE.
+ * @return false si algun parametro es invalido.
+ */
+bool osMessageBufferInit(osMessageBufferObject* buffer, void* storage, const uint32_t size);
+/**
+ * @brief Envia un mensaje completo, esperando a que haya lugar para todo el mensaje. Si ya hay emisores
+ *        esperando, hace fila detras de ellos aunque el mensaje entre.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK, u OS_ERROR si el mensaje esta vacio o no entra ni con el buffer vacio.
+ */
+osResultType osMessageBufferSend(osMessageBufferObject* buffer, const void* message, const uint32_t length, const uint32_t timeout);
+/**
+ * @brief Recibe el proximo mensaje completo, esperando si no hay ninguno.
+ * @param capacity Tamaño de message; si el mensaje no entra se devuelve OS_ERROR y queda en el buffer.
+ * @param length Recibe el largo del mensaje (tambien con OS_ERROR, para saber cuanto lugar hace falta).
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK u OS_ERROR.
+ */
+osResultType osMessageBufferReceive(osMessageBufferObject* buffer, void* message, const uint32_t capacity, uint32_t* length, const uint32_t timeout);
+/**
+ * @brief Largo del proximo mensaje, sin sacarlo.
+ * @return Largo en bytes, 0 si no hay mensajes.
+ */
+uint32_t osMessageBufferPeekLength(osMessageBufferObject* buffer);
+
+
+#endif // INC_OSMESSAGEBUFFER_H
@@ -0,0 +1,51 @@
+#ifndef INC_OSMUTEX_H
+#define INC_OSMUTEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+
+
+typedef enum{
+    OS_MUTEX_INHERIT    = 0,    // El dueño hereda la prioridad de la tarea mas prioritaria que lo espera
+    OS_MUTEX_CEILING    = 1,    // Techo inmediato: el dueño corre a la prioridad techo mientras lo posea
+}osMutexProtocolType;
+
+typedef struct osMutexObject
+{
+	struct osTaskObject* owner;			// Tarea que lo posee, NULL si esta libre
+	uint32_t lockCount;					// Veces que el dueño lo tomo (bloqueo recursivo)
+	osMutexProtocolType protocol;
+	osPriorityType ceiling;				// Prioridad techo, solo con OS_MUTEX_CEILING
+	osTaskListObject waitList;			// Tareas bloqueadas, ordenadas por prioridad
+	struct osMutexObject* ownerNext;	// Siguiente mutex del mismo dueño
+
+
+}osMutexObject;
+
+/**
+ * @brief Inicializa un mutex libre.
+ * @param protocol OS_MUTEX_INHERIT u OS_MUTEX_CEILING.
+ * @param ceiling Prioridad de la tarea mas prioritaria que lo usa (se ignora con OS_MUTEX_INHERIT).
+ */
+void osMutexInit(osMutexObject* mutex, osMutexProtocolType protocol, osPriorityType ceiling);
+/**
+ * @brief Toma el mutex, bloqueando a la tarea hasta que se libere o venza el timeout.
+ *
+ * El dueño puede volver a tomarlo; queda libre cuando lo devuelve la misma cantidad de veces.
+ * Solo se puede llamar desde una tarea.
+ *
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK (ocupado y timeout 0), u OS_ERROR (desde cualquier handler, con el SO
+ *         detenido o, con OS_MUTEX_CEILING, si la tarea es mas prioritaria que el techo).
+ */
+osResultType osMutexLock(osMutexObject* mutex, const uint32_t timeout);
+/**
+ * @brief Devuelve el mutex. Al liberarlo la tarea recupera su prioridad y se lo entrega a la mas prioritaria que espera.
+ * @return OS_OK, u OS_ERROR si la tarea no es su dueña o se llama desde un handler de interrupcion.
+ */
+osResultType osMutexUnlock(osMutexObject* mutex);
+
+
+#endif // INC_OSMUTEX_H
@@ -0,0 +1,82 @@
+#ifndef INC_OSPOOL_H
+#define INC_OSPOOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+
+// Bloques del pool: al menos un puntero (enlace de la lista libre) y multiplos de 8 bytes
+#define OS_POOL_BLOCK_STRIDE(blockSize)         ((((blockSize) < sizeof(void*) ? sizeof(void*) : (blockSize)) + 7U) & ~7U)
+// Bytes del buffer que recibe osPoolInit
+#define OS_POOL_BUFFER_SIZE(count, blockSize)   ((count) * OS_POOL_BLOCK_STRIDE(blockSize))
+
+typedef struct
+{
+	uint8_t *blocks;				// count bloques de blockSize bytes, provistos por el llamador
+	uint32_t blockSize;				// Tamaño util pedido en osPoolInit
+	uint32_t blockStride;			// Distancia entre bloques (OS_POOL_BLOCK_STRIDE)
+	uint32_t count;
+	void *freeList;					// Bloques libres, enlazados por su primera palabra
+	uint32_t freeCount;
+	uint32_t minFree;				// Menor cantidad de bloques libres desde osPoolInit
+	uint32_t failCount;				// Pedidos que no obtuvieron bloque (OS_TIMEOUT u OS_WOULD_BLOCK)
+	osTaskListObject waitList;		// Tareas esperando un bloque libre
+
+
+}osPoolObject;
+
+typedef struct
+{
+	uint32_t blockSize;				// Tamaño pedido en osPoolInit
+	uint32_t blockStride;			// Bytes que ocupa cada bloque en el buffer
+	uint32_t count;
+	uint32_t used;					// Bloques entregados en este momento
+	uint32_t peakUsed;				// Maximo de bloques entregados a la vez
+	uint32_t failCount;
+}osPoolStatsObject;
+
+/**
+ * @brief Inicializa un pool de bloques de tamaño fijo sobre un buffer del llamador. Pedir y devolver un
+ *        bloque cuesta siempre lo mismo, sin heap.
+ * @param buffer Buffer de OS_POOL_BUFFER_SIZE(count, blockSize) bytes, alineado a 8 bytes.
+ * @param blockSize Tamaño util de cada bloque en bytes.
+ * @param count Cantidad de bloques.
+ * @return false si algun parametro es invalido.
+ */
+bool osPoolInit(osPoolObject* pool, void* buffer, const uint32_t blockSize, const uint32_t count);
+/**
+ * @brief Pide un bloque, esperando que se libere uno si no hay. Se puede llamar desde una ISR con timeout 0.
+ * @param block Recibe el bloque, o NULL si no se obtuvo.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT u OS_WOULD_BLOCK (sin bloques y sin poder esperar).
+ */
+osResultType osPoolAlloc(osPoolObject* pool, void** block, const uint32_t timeout);
+/**
+ * @brief Devuelve un bloque al pool y despierta a una tarea que espera uno. Se puede llamar desde una ISR.
+ *
+ * Detecta la doble liberacion: un bloque libre lleva una marca en su segunda palabra, y solo si el bloque
+ * que se devuelve la tiene se recorre la lista de libres para confirmarlo.
+ *
+ * @return OS_OK, u OS_ERROR si el puntero no es el comienzo de un bloque del pool o el bloque ya estaba libre.
+ */
+osResultType osPoolFree(osPoolObject* pool, void* block);
+/**
+ * @brief Indica si el puntero es el comienzo de uno de los bloques del pool, libre o no.
+ */
+bool osPoolOwnsBlock(osPoolObject* pool, void* block);
+/**
+ * @brief Indica si el puntero es un bloque del pool entregado por osPoolAlloc y todavia no devuelto.
+ */
+bool osPoolIsAllocated(osPoolObject* pool, void* block);
+/**
+ * @brief Copia las estadisticas de uso del pool.
+ */
+void osPoolGetStats(osPoolObject* pool, osPoolStatsObject* stats);
+/**
+ * @brief Elige en que orden se despiertan las tareas bloqueadas (OS_WAIT_FIFO por defecto).
+ */
+void osPoolSetWaitOrder(osPoolObject* pool, osWaitOrderType order);
+
+
+#endif // INC_OSPOOL_H
@@ -5,24 +5,133 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#define MAX_SIZE_QUEUE  128     // Maximum buffer
-#define OS_MAX_DELAY    0xFFFFFFFF  // Macro where the queue is locked forever. It ignores the timeout variable in the implementation.
+#include "osTaskList.h"
+#include "osPool.h"
+
+struct osQueueSetObject;
+
+#define OS_QUEUE_BUFFER_SIZE(capacity, dataSize)    ((capacity) * (dataSize))  // Bytes del buffer que recibe osQueueInit
+// Bytes del buffer que recibe osQueueInitZeroCopy: los bloques (un pool), el anillo de punteros y el pool
+#define OS_QUEUE_ZC_BUFFER_SIZE(capacity, blockSize) \
+    (OS_POOL_BUFFER_SIZE(capacity, blockSize) + (capacity) * sizeof(void*) + sizeof(osPoolObject))
 
 typedef struct
 {
-	uint8_t *data[MAX_SIZE_QUEUE];
-	//osTaskObject* assignedTaskQ;
-	uint32_t startIndex;
-	uint32_t endIndex;
+	uint8_t *data;					// Buffer de capacity elementos de dataSize bytes, provisto por el llamador
+	uint32_t capacity;				// Cantidad maxima de elementos
+	uint32_t startIndex;			// Proximo elemento a recibir
+	uint32_t endIndex;				// Proximo lugar libre
 	uint32_t dataSize;
 	uint32_t currentSize;
+	osPoolObject *pool;				// Sin copia: pool de capacity bloques, al final del buffer; NULL en una cola que copia
+	osTaskListObject waitSend;		// Tareas bloqueadas por cola llena (sin copia esperan en el pool)
+	osTaskListObject waitReceive;	// Tareas bloqueadas por cola vacia
+	struct osQueueSetObject *set;	// Conjunto al que avisa cuando recibe un elemento, NULL si no pertenece a uno
 
 
 }osQueueObject;
 
-bool osQueueInit(osQueueObject* queue, const uint32_t dataSize);
+/**
+ * @brief Inicializa una cola vacia sobre un buffer del llamador. Enviar y recibir copian en el buffer, sin heap.
+ * @param buffer Buffer de OS_QUEUE_BUFFER_SIZE(capacity, dataSize) bytes, alineado para el tipo de elemento.
+ * @param capacity Cantidad maxima de elementos.
+ * @param dataSize Tamaño de cada elemento en bytes.
+ * @return false si algun parametro es invalido.
+ */
+bool osQueueInit(osQueueObject* queue, void* buffer, const uint32_t capacity, const uint32_t dataSize);
 
-bool osQueueSend(osQueueObject* queue, const void* data, const uint32_t timeout);
-bool osQueueReceive(osQueueObject* queue, void* buffer, const uint32_t timeout);
+/**
+ * @brief Envia un elemento, esperando lugar si la cola esta llena.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK si se envio, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si estaba llena y no se podia esperar.
+ */
+osResultType osQueueSend(osQueueObject* queue, const void* data, const uint32_t timeout);
+/**
+ * @brief Recibe un elemento, esperando datos si la cola esta vacia.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK si se recibio, OS_TIMEOUT si vencio la espera, OS_WOULD_BLOCK si estaba vacia y no se podia esperar.
+ */
+osResultType osQueueReceive(osQueueObject* queue, void* buffer, const uint32_t timeout);
+/**
+ * @brief Envia un elemento sin esperar nunca: si la cola esta llena descarta el mas viejo.
+ *
+ * Con capacidad 1 la cola funciona como buzon donde gana el ultimo valor (p. ej. la ultima lectura de
+ * un sensor). Se puede llamar desde una ISR.
+ *
+ * @return OS_OK, u OS_ERROR en una cola sin copia.
+ */
+osResultType osQueueOverwrite(osQueueObject* queue, const void* data);
+/**
+ * @brief Copia el primer elemento sin quitarlo de la cola, esperando datos si esta vacia.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar (desde una ISR) u OS_MAX_DELAY.
+ * @return OS_OK si se copio, OS_TIMEOUT, OS_WOULD_BLOCK si estaba vacia y no se podia esperar, u OS_ERROR
+ *         en una cola sin copia.
+ */
+osResultType osQueuePeek(osQueueObject* queue, void* buffer, const uint32_t timeout);
+/**
+ * @brief Envia hasta count elementos consecutivos en una sola seccion critica.
+ *
+ * Espera solo si la cola esta llena; envia los que entren y despierta receptores con un unico pedido de
+ * cambio de contexto para todo el lote.
+ *
+ * @param items count elementos de dataSize bytes, uno detras de otro.
+ * @param sent Recibe la cantidad enviada (0 si no se envio ninguno).
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT) por el primer lugar libre, 0 para no esperar u OS_MAX_DELAY.
+ * @return OS_OK si envio al menos uno, OS_TIMEOUT, OS_WOULD_BLOCK u OS_ERROR (count cero o cola sin copia).
+ */
+osResultType osQueueSendBatch(osQueueObject* queue, const void* items, const uint32_t count, uint32_t* sent, const uint32_t timeout);
+/**
+ * @brief Recibe hasta count elementos en una sola seccion critica.
+ *
+ * Espera solo si la cola esta vacia; recibe los que haya y despierta emisores con un unico pedido de
+ * cambio de contexto para todo el lote.
+ *
+ * @param buffer Lugar para count elementos de dataSize bytes.
+ * @param received Recibe la cantidad recibida (0 si no se recibio ninguno).
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT) por el primer elemento, 0 para no esperar u OS_MAX_DELAY.
+ * @return OS_OK si recibio al menos uno, OS_TIMEOUT, OS_WOULD_BLOCK u OS_ERROR (count cero o cola sin copia).
+ */
+osResultType osQueueReceiveBatch(osQueueObject* queue, void* buffer, const uint32_t count, uint32_t* received, const uint32_t timeout);
+/**
+ * @brief Inicializa una cola sin copia: transfiere la propiedad de bloques de blockSize bytes en lugar de copiarlos.
+ *
+ * El productor toma un bloque con osQueueAllocBlock, lo llena y lo envia con osQueueCommitBlock; el consumidor
+ * lo recibe con osQueueReceiveBlock y lo devuelve con osQueueReleaseBlock. Solo se copia el puntero.
+ * osQueueSend y osQueueReceive no se pueden usar sobre esta cola.
+ *
+ * @param buffer Buffer de OS_QUEUE_ZC_BUFFER_SIZE(capacity, blockSize) bytes alineado a 8.
+ * @param capacity Cantidad de bloques (en la cola o en uso por productores y consumidores).
+ * @param blockSize Tamaño util de cada bloque en bytes.
+ * @return false si algun parametro es invalido.
+ */
+bool osQueueInitZeroCopy(osQueueObject* queue, void* buffer, const uint32_t capacity, const uint32_t blockSize);
+/**
+ * @brief Toma un bloque libre para llenarlo, esperando si todos estan en uso.
+ * @param block Recibe el bloque; el productor es su dueño hasta enviarlo.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK u OS_ERROR si la cola copia los elementos.
+ */
+osResultType osQueueAllocBlock(osQueueObject* queue, void** block, const uint32_t timeout);
+/**
+ * @brief Envia un bloque obtenido con osQueueAllocBlock. Nunca espera: siempre hay lugar para los bloques de la cola.
+ * @return OS_OK, u OS_ERROR si el bloque no pertenece a la cola, esta libre o ya se envio y la cola esta llena.
+ */
+osResultType osQueueCommitBlock(osQueueObject* queue, void* block);
+/**
+ * @brief Recibe el proximo bloque sin copiarlo, esperando si la cola esta vacia.
+ * @param block Recibe el bloque; el consumidor es su dueño hasta devolverlo.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK u OS_ERROR si la cola copia los elementos.
+ */
+osResultType osQueueReceiveBlock(osQueueObject* queue, void** block, const uint32_t timeout);
+/**
+ * @brief Devuelve un bloque recibido (o tomado y no enviado) a los libres.
+ * @return OS_OK, u OS_ERROR si el bloque no pertenece a la cola o ya estaba libre.
+ */
+osResultType osQueueReleaseBlock(osQueueObject* queue, void* block);
+/**
+ * @brief Elige en que orden se despiertan las tareas bloqueadas (OS_WAIT_FIFO por defecto).
+ */
+void osQueueSetWaitOrder(osQueueObject* queue, osWaitOrderType order);
 
 #endif // INC_OSQUEUE_H
@@ -0,0 +1,63 @@
+#ifndef INC_OSQUEUESET_H
+#define INC_OSQUEUESET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+#include "osQueue.h"
+#include "osSemaphore.h"
+
+#ifndef OS_QUEUE_SET_MAX_MEMBERS
+#define OS_QUEUE_SET_MAX_MEMBERS    8U      // Colas y semaforos por conjunto
+#endif
+
+typedef enum{
+    OS_SET_MEMBER_QUEUE     = 0,
+    OS_SET_MEMBER_SEMAPHORE = 1,
+}osQueueSetMemberType;
+
+typedef struct
+{
+	void* object;					// osQueueObject u osSemaphoreObject
+	osQueueSetMemberType type;
+}osQueueSetMember;
+
+typedef struct osQueueSetObject
+{
+	osQueueSetMember members[OS_QUEUE_SET_MAX_MEMBERS];
+	uint32_t memberCount;
+	uint32_t nextMember;			// Donde empieza la proxima busqueda (reparte entre miembros listos)
+	osTaskListObject waitList;		// Tareas esperando que algun miembro este listo
+
+
+}osQueueSetObject;
+
+/**
+ * @brief Inicializa un conjunto vacio.
+ */
+void osQueueSetInit(osQueueSetObject* set);
+/**
+ * @brief Agrega una cola (con copia o sin copia) al conjunto. Se llama antes de usar la cola.
+ * @return false si el conjunto esta lleno o la cola ya pertenece a un conjunto.
+ */
+bool osQueueSetAddQueue(osQueueSetObject* set, osQueueObject* queue);
+/**
+ * @brief Agrega un semaforo al conjunto. Se llama antes de usar el semaforo.
+ * @return false si el conjunto esta lleno o el semaforo ya pertenece a un conjunto.
+ */
+bool osQueueSetAddSemaphore(osQueueSetObject* set, osSemaphoreObject* semaphore);
+/**
+ * @brief Espera a que alguna cola del conjunto tenga datos o algun semaforo tenga unidades.
+ *
+ * No consume nada: devuelve el miembro listo y el llamador lo lee con osQueueReceive (o
+ * osQueueReceiveBlock) u osSemaphoreTake con timeout 0. Si varios estan listos se reparten por turnos.
+ *
+ * @param member Recibe el osQueueObject u osSemaphoreObject listo.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT, OS_WOULD_BLOCK (ninguno listo y no se puede esperar) u OS_ERROR si el conjunto esta vacio.
+ */
+osResultType osSelect(osQueueSetObject* set, void** member, const uint32_t timeout);
+
+
+#endif // INC_OSQUEUESET_H
@@ -0,0 +1,63 @@
+#ifndef INC_OSRING_H
+#define INC_OSRING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+
+
+/**
+ * Anillo sin bloqueos de un productor y un consumidor (p. ej. una ISR y una tarea).
+ *
+ * Cada indice lo escribe un solo lado: el productor publica head despues de copiar los elementos y el
+ * consumidor publica tail despues de leerlos, con barreras de memoria en el medio. Ninguna operacion
+ * deshabilita las interrupciones. Con mas de un productor o mas de un consumidor hace falta otra primitiva.
+ */
+typedef struct
+{
+	uint8_t* data;								// Buffer de capacity elementos de itemSize bytes
+	uint32_t capacity;							// Potencia de dos
+	uint32_t itemSize;
+	volatile uint32_t head;						// Elementos escritos (solo lo modifica el productor)
+	volatile uint32_t tail;						// Elementos leidos (solo lo modifica el consumidor)
+	struct osTaskObject* volatile consumer;		// Tarea esperando en osRingPopWait, NULL si no hay
+
+
+}osRingObject;
+
+/**
+ * @brief Inicializa un anillo vacio sobre un buffer del llamador.
+ * @param buffer Buffer de capacity * itemSize bytes.
+ * @param capacity Cantidad de elementos, potencia de dos.
+ * @param itemSize Tamaño de cada elemento en bytes.
+ * @return false si algun parametro es invalido.
+ */
+bool osRingInit(osRingObject* ring, void* buffer, const uint32_t capacity, const uint32_t itemSize);
+/**
+ * @brief Agrega hasta count elementos (productor). Si el consumidor espera en osRingPopWait lo despierta.
+ * @return Elementos agregados; menos que count si el anillo se lleno.
+ */
+uint32_t osRingPush(osRingObject* ring, const void* items, const uint32_t count);
+/**
+ * @brief Saca hasta count elementos sin esperar (consumidor).
+ * @return Elementos leidos, 0 si estaba vacio.
+ */
+uint32_t osRingPop(osRingObject* ring, void* items, const uint32_t count);
+/**
+ * @brief Saca hasta count elementos, esperando a que haya al menos uno (solo desde la tarea consumidora).
+ *
+ * La espera usa la notificacion directa de la tarea (osTaskNotifyWait): mientras espera no debe
+ * esperar otras notificaciones.
+ *
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return Elementos leidos, 0 si vencio el timeout.
+ */
+uint32_t osRingPopWait(osRingObject* ring, void* items, const uint32_t count, const uint32_t timeout);
+/**
+ * @brief Elementos disponibles para el consumidor.
+ */
+uint32_t osRingCount(osRingObject* ring);
+
+
+#endif // INC_OSRING_H
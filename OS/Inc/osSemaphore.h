@@ -4,20 +4,53 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "osTaskList.h"
+
+struct osQueueSetObject;
 
 
 typedef struct
 {
 	uint32_t  maxCount;
-	uint32_t  count;
-	bool  lockedFlag;
+	volatile uint32_t  count;	// Unidades disponibles, entre 0 y maxCount
+	osTaskListObject waitList;	// Tareas bloqueadas esperando el semaforo
+	struct osQueueSetObject* set;	// Conjunto al que avisa cuando recibe unidades, NULL si no pertenece a uno
 
 
 }osSemaphoreObject;
 
+/**
+ * @brief Inicializa un semaforo contador.
+ * @param maxCount Maximo de unidades que puede acumular (1 para un semaforo binario).
+ * @param count Unidades disponibles al inicio (se limita a maxCount).
+ */
 void osSemaphoreInit(osSemaphoreObject* semaphore, const uint32_t maxCount, const uint32_t count);
-bool osSemaphoreTake(osSemaphoreObject* semaphore);
-void osSemaphoreGive(osSemaphoreObject* semaphore);
+/**
+ * @brief Toma una unidad, bloqueando a la tarea hasta que haya una disponible o venza el timeout.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY para esperar indefinidamente.
+ * @return OS_OK, OS_TIMEOUT u OS_WOULD_BLOCK (sin unidades y sin poder esperar, p. ej. desde una ISR).
+ */
+osResultType osSemaphoreTake(osSemaphoreObject* semaphore, const uint32_t timeout);
+/**
+ * @brief Toma count unidades juntas, bloqueando a la tarea hasta que esten disponibles o venza el timeout.
+ *        No se adelanta a las tareas que ya esperan: si hay alguna delante, espera su turno aunque alcancen.
+ * @return Igual que osSemaphoreTake, u OS_ERROR si count es cero o supera maxCount.
+ */
+osResultType osSemaphoreTakeN(osSemaphoreObject* semaphore, const uint32_t count, const uint32_t timeout);
+/**
+ * @brief Devuelve una unidad. Se puede llamar desde una ISR.
+ * @return false si el semaforo ya tenia maxCount unidades.
+ */
+bool osSemaphoreGive(osSemaphoreObject* semaphore);
+/**
+ * @brief Devuelve count unidades en una sola llamada (p. ej. varias transferencias DMA). Se puede llamar desde una ISR.
+ * @return false si se superaria maxCount; en ese caso no se entrega ninguna unidad.
+ */
+bool osSemaphoreGiveN(osSemaphoreObject* semaphore, const uint32_t count);
+/**
+ * @brief Elige en que orden se despiertan las tareas bloqueadas (OS_WAIT_FIFO por defecto).
+ */
+void osSemaphoreSetWaitOrder(osSemaphoreObject* semaphore, osWaitOrderType order);
 
 
 #endif // INC_OSSEMAPHORE_H
@@ -0,0 +1,59 @@
+#ifndef INC_OSSTREAMBUFFER_H
+#define INC_OSSTREAMBUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+#include "osRing.h"
+
+
+/**
+ * Flujo de bytes de un escritor y un lector (p. ej. la ISR de una UART y la tarea que procesa lo recibido).
+ *
+ * Los bytes viajan por un osRingObject, asi que escribir y leer no deshabilitan las interrupciones. El lector
+ * solo se despierta cuando hay triggerLevel bytes, y un escritor que es tarea puede esperar lugar.
+ */
+typedef struct
+{
+	osRingObject ring;							// Bytes, capacidad potencia de dos
+	uint32_t triggerLevel;						// Bytes que tienen que llegar para despertar al lector
+	volatile uint32_t readerTrigger;			// Bytes que espera el lector bloqueado (triggerLevel o menos)
+	struct osTaskObject* volatile reader;		// Lector bloqueado, NULL si no hay
+	struct osTaskObject* volatile writer;		// Escritor bloqueado por falta de lugar, NULL si no hay
+
+
+}osStreamBufferObject;
+
+/**
+ * @brief Inicializa un stream vacio sobre un buffer del llamador.
+ * @param buffer Buffer de size bytes.
+ * @param size Capacidad en bytes, potencia de dos.
+ * @param triggerLevel Bytes que despiertan al lector, entre 1 y size.
+ * @return false si algun parametro es invalido.
+ */
+bool osStreamBufferInit(osStreamBufferObject* stream, void* buffer, const uint32_t size, const uint32_t triggerLevel);
+/**
+ * @brief Escribe hasta length bytes. Desde una ISR se llama con timeout 0 y escribe lo que entra.
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT) por lugar para el resto, 0 para no esperar u OS_MAX_DELAY.
+ * @return Bytes escritos; menos que length si vencio el timeout.
+ */
+uint32_t osStreamBufferWrite(osStreamBufferObject* stream, const void* data, const uint32_t length, const uint32_t timeout);
+/**
+ * @brief Lee hasta length bytes, esperando a que haya triggerLevel (o length, si es menor).
+ * @param timeout Ticks maximos de espera (hasta OS_MAX_TIMEOUT), 0 para no esperar u OS_MAX_DELAY. Al vencer devuelve lo que haya.
+ * @return Bytes leidos, 0 si vencio sin datos.
+ */
+uint32_t osStreamBufferRead(osStreamBufferObject* stream, void* data, const uint32_t length, const uint32_t timeout);
+/**
+ * @brief Cambia el nivel de disparo (entre 1 y la capacidad); vale desde la proxima lectura.
+ * @return false si el nivel es invalido.
+ */
+bool osStreamBufferSetTriggerLevel(osStreamBufferObject* stream, const uint32_t triggerLevel);
+/**
+ * @brief Bytes disponibles para el lector.
+ */
+uint32_t osStreamBufferAvailable(osStreamBufferObject* stream);
+
+
+#endif // INC_OSSTREAMBUFFER_H
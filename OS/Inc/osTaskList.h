@@ -0,0 +1,50 @@
+#ifndef INC_OSTASKLIST_H
+#define INC_OSTASKLIST_H
+
+#include <stdint.h>
+
+#define OS_MAX_DELAY    0xFFFFFFFF  // Timeout infinito: la tarea espera hasta que la operacion se complete
+// Espera finita mas larga: los vencimientos se comparan con resta con signo sobre el contador de ticks.
+// Un timeout mayor (distinto de OS_MAX_DELAY) se limita a este valor, unos 24 dias a 1 kHz
+#define OS_MAX_TIMEOUT  0x7FFFFFFFU
+
+struct osTaskObject;
+
+typedef enum{
+    OS_OK           = 0,    // La operacion se completo
+    OS_TIMEOUT      = 1,    // Vencio el timeout antes de poder completarla
+    OS_WOULD_BLOCK  = 2,    // No se podia completar sin esperar y no se puede bloquear (timeout 0, ISR o SO detenido)
+    OS_ERROR        = 3,    // Parametros invalidos
+}osResultType;
+
+typedef enum{
+    OS_VERYHIGH_PRIORITY    = 0,                // Highest Priority
+    OS_HIGH_PRIORITY    	= 1,
+    OS_NORMAL_PRIORITY    	= 2,
+    OS_LOW_PRIORITY    		= 3,                // Less Priority
+}osPriorityType;
+
+typedef enum{
+    OS_WAIT_FIFO        = 0,    // Las tareas se despiertan en orden de llegada
+    OS_WAIT_PRIORITY    = 1,    // Se despierta primero la de mayor prioridad (FIFO entre iguales)
+}osWaitOrderType;
+
+/**
+ * @brief Lista intrusiva de tareas (enlaza por taskNext/taskPrev del TCB).
+ *
+ * La usa el kernel para las colas de listas de cada prioridad y cada semaforo o cola para sus
+ * tareas bloqueadas. Una tarea esta en una sola de estas listas a la vez.
+ */
+typedef struct
+{
+    struct osTaskObject* head;
+    struct osTaskObject* tail;
+    osWaitOrderType order;
+}osTaskListObject;
+
+/**
+ * @brief Deja una lista de espera vacia, con el orden en que se despiertan sus tareas.
+ */
+void osTaskListInit(osTaskListObject* list, osWaitOrderType order);
+
+#endif // INC_OSTASKLIST_H
@@ -0,0 +1,72 @@
+#ifndef INC_OSTIMER_H
+#define INC_OSTIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osTaskList.h"
+
+#ifndef OS_TIMER_TASK_PRIORITY
+#define OS_TIMER_TASK_PRIORITY  OS_VERYHIGH_PRIORITY    // Los callbacks se atrasan lo menos posible respecto del tick
+#endif
+#ifndef OS_TIMER_STACK_SIZE
+// Stack compartido por todos los callbacks. Alcanza para el contexto guardado (68 B), la espera del servicio
+// (~100 B con el scheduler) y callbacks cortos como los de la aplicacion; subirlo si un callback usa mas
+#define OS_TIMER_STACK_SIZE     256U
+#endif
+
+typedef void (*osTimerCallback)(void* data);
+
+typedef struct osTimerObject
+{
+	osTimerCallback callback;			// Se ejecuta en la tarea de timers, no en el SysTick
+	void* data;							// Argumento del callback
+	uint32_t period;					// Ticks entre el arranque y el vencimiento (y entre vencimientos)
+	uint32_t expiryTick;				// Tick absoluto del proximo vencimiento
+	bool autoReload;					// true: periodico, false: una sola vez
+	bool active;						// Esta en la lista de vencimientos
+	struct osTimerObject* next;			// Lista de timers activos, ordenada por expiryTick
+	struct osTimerObject* prev;
+
+
+}osTimerObject;
+
+/**
+ * @brief Inicializa un timer detenido.
+ * @param callback Funcion a ejecutar al vencer; corre en la tarea de timers y no debe bloquearse mucho tiempo.
+ * @param data Argumento del callback.
+ * @param period Ticks hasta el vencimiento, mayor que cero y hasta OS_MAX_TIMEOUT.
+ * @param autoReload true para que se rearme solo cada period ticks.
+ */
+void osTimerInit(osTimerObject* timer, osTimerCallback callback, void* data, const uint32_t period, const bool autoReload);
+/**
+ * @brief Arranca un timer detenido; si ya esta corriendo no cambia su vencimiento. Se puede llamar desde una ISR.
+ * @return false si el timer no tiene callback o su periodo es invalido.
+ */
+bool osTimerStart(osTimerObject* timer);
+/**
+ * @brief Vuelve a contar el periodo desde ahora, este corriendo o no. Se puede llamar desde una ISR.
+ * @return false si el timer no tiene callback o su periodo es invalido.
+ */
+bool osTimerReset(osTimerObject* timer);
+/**
+ * @brief Detiene el timer; si ya vencio, su callback en curso termina igual. Se puede llamar desde una ISR.
+ */
+void osTimerStop(osTimerObject* timer);
+/**
+ * @brief Cambia el periodo; se aplica desde el proximo osTimerStart/osTimerReset (o la proxima recarga).
+ * @return false si period es cero o mayor que OS_MAX_TIMEOUT.
+ */
+bool osTimerSetPeriod(osTimerObject* timer, const uint32_t period);
+/**
+ * @brief Indica si el timer esta corriendo.
+ */
+bool osTimerIsActive(osTimerObject* timer);
+/**
+ * @brief Crea la tarea de timers. La llama osStart() cuando OS_USE_TIMERS es 1.
+ * @return false si no hay lugar para la tarea.
+ */
+bool osTimerServiceInit(void);
+
+
+#endif // INC_OSTIMER_H
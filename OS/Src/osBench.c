@@ -0,0 +1,187 @@
+/*
+ * osBench.c
+ *
+ * Mediciones de ciclos de las primitivas del kernel. Solo se compila con OS_KERNEL_STATS en 1: los buffers
+ * de prueba no ocupan RAM en el build normal.
+ */
+#include <string.h>
+
+#include <osBench.h>
+#include "osKernel.h"
+
+#if OS_KERNEL_STATS
+
+static const uint32_t benchSizes[OS_BENCH_SIZES] = {8U, 64U, 512U};
+
+static osQueueObject benchQueue;
+static uint8_t benchBuffer[OS_QUEUE_ZC_BUFFER_SIZE(1, OS_BENCH_MAX_SIZE)] OS_STACK_ALIGN;
+static uint8_t benchMessage[OS_BENCH_MAX_SIZE];
+static uint8_t benchReceived[OS_BENCH_MAX_SIZE];
+static uint64_t benchItems[OS_BENCH_BATCH];
+static uint64_t benchItemsReceived[OS_BENCH_BATCH];
+static volatile uint8_t benchSink;          // Evita que el compilador descarte la lectura del mensaje
+static osSemaphoreObject benchSemaphore;
+static osTaskObject* benchTask;             // Tarea que despierta benchWakeNotify
+static volatile uint32_t benchIrqStamp;     // CYCCNT al entrar al handler de la IRQ de prueba
+
+/**
+ * @brief Habilita el contador de ciclos si todavia no corre (osStart lo habilita con OS_KERNEL_STATS).
+ */
+static void benchEnableCounter(void);
+/**
+ * @brief Ciclos que cuesta leer el contador dos veces seguidas, para descontarlos de cada medicion.
+ */
+static uint32_t benchOverhead(void);
+/**
+ * @brief Handlers de la IRQ de prueba: marcan la entrada y despiertan a la tarea por cada camino.
+ */
+static void benchWakeSemaphore(void* data);
+static void benchWakeNotify(void* data);
+
+
+void osBenchQueue(osBenchQueueObject* result){
+    uint32_t overhead, start, cycles, best, moved;
+    void* block;
+
+    benchEnableCounter();
+    overhead = benchOverhead();
+
+    for (uint32_t s = 0; s < OS_BENCH_SIZES; s++)
+    {
+        const uint32_t size = benchSizes[s];
+
+        result->size[s] = size;
+
+        // Copia: el mensaje se arma en el buffer del productor y viaja por dos memcpy
+        osQueueInit(&benchQueue, benchBuffer, 1, size);
+        best = UINT32_MAX;
+        for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+        {
+            start = DWT->CYCCNT;
+            memset(benchMessage, (int)i, size);
+            osQueueSend(&benchQueue, benchMessage, 0);
+            osQueueReceive(&benchQueue, benchReceived, 0);
+            benchSink = benchReceived[0];
+            cycles = DWT->CYCCNT - start;
+            if (cycles < best) best = cycles;
+        }
+        result->copyCycles[s] = best - overhead;
+
+        // Sin copia: el mensaje se arma directo en el bloque y solo viaja el puntero
+        osQueueInitZeroCopy(&benchQueue, benchBuffer, 1, size);
+        best = UINT32_MAX;
+        for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+        {
+            start = DWT->CYCCNT;
+            osQueueAllocBlock(&benchQueue, &block, 0);
+            memset(block, (int)i, size);
+            osQueueCommitBlock(&benchQueue, block);
+            osQueueReceiveBlock(&benchQueue, &block, 0);
+            benchSink = *(uint8_t*)block;
+            osQueueReleaseBlock(&benchQueue, block);
+            cycles = DWT->CYCCNT - start;
+            if (cycles < best) best = cycles;
+        }
+        result->zeroCopyCycles[s] = best - overhead;
+    }
+
+    // Lotes: la misma cola, OS_BENCH_BATCH elementos por iteracion, de a uno o juntos
+    osQueueInit(&benchQueue, benchBuffer, OS_BENCH_BATCH, sizeof(uint64_t));
+    best = UINT32_MAX;
+    for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+    {
+        start = DWT->CYCCNT;
+        for (uint32_t n = 0; n < OS_BENCH_BATCH; n++) osQueueSend(&benchQueue, &benchItems[n], 0);
+        for (uint32_t n = 0; n < OS_BENCH_BATCH; n++) osQueueReceive(&benchQueue, &benchItemsReceived[n], 0);
+        cycles = DWT->CYCCNT - start;
+        if (cycles < best) best = cycles;
+    }
+    result->perItemCycles = (best - overhead) / OS_BENCH_BATCH;
+
+    best = UINT32_MAX;
+    for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+    {
+        start = DWT->CYCCNT;
+        osQueueSendBatch(&benchQueue, benchItems, OS_BENCH_BATCH, &moved, 0);
+        osQueueReceiveBatch(&benchQueue, benchItemsReceived, OS_BENCH_BATCH, &moved, 0);
+        cycles = DWT->CYCCNT - start;
+        if (cycles < best) best = cycles;
+    }
+    result->batchCycles = (best - overhead) / OS_BENCH_BATCH;
+}
+
+void osBenchWake(osBenchWakeObject* result, osIRQnType irq){
+    uint32_t overhead, cycles;
+    osResultType waitResult;
+
+    result->semaphoreCycles = UINT32_MAX;
+    result->notifyCycles = UINT32_MAX;
+    result->semaphoreBytes = sizeof(osSemaphoreObject);
+    result->notifyBytes = sizeof(((osTaskObject*)0)->taskNotifyValue) + sizeof(((osTaskObject*)0)->taskNotifyState);
+
+    benchTask = osGetRunningTask();
+    if (benchTask == NULL) return;
+
+    benchEnableCounter();
+    overhead = benchOverhead();
+
+    // Semaforo: la IRQ entra al bloquearse la tarea y el give la despierta
+    osSemaphoreInit(&benchSemaphore, 1, 0);
+    if (!osRegisterIRQ(irq, benchWakeSemaphore, NULL)) return;
+    for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+    {
+        osEnterCriticalSection();
+        NVIC_SetPendingIRQ(irq);
+        waitResult = osSemaphoreTake(&benchSemaphore, OS_MAX_DELAY);
+        cycles = DWT->CYCCNT - benchIrqStamp;
+        if (waitResult == OS_OK && cycles - overhead < result->semaphoreCycles) result->semaphoreCycles = cycles - overhead;
+    }
+    osUnregisterIRQ(irq);
+
+    // Notificacion directa: el mismo recorrido sin objeto intermedio
+    if (!osRegisterIRQ(irq, benchWakeNotify, NULL)) return;
+    for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+    {
+        osEnterCriticalSection();
+        NVIC_SetPendingIRQ(irq);
+        waitResult = osTaskNotifyWait(0, 0xFFFFFFFFU, NULL, OS_MAX_DELAY);
+        cycles = DWT->CYCCNT - benchIrqStamp;
+        if (waitResult == OS_OK && cycles - overhead < result->notifyCycles) result->notifyCycles = cycles - overhead;
+    }
+    osUnregisterIRQ(irq);
+}
+
+static void benchWakeSemaphore(void* data){
+    (void)data;
+    benchIrqStamp = DWT->CYCCNT;
+    osSemaphoreGive(&benchSemaphore);
+}
+
+static void benchWakeNotify(void* data){
+    (void)data;
+    benchIrqStamp = DWT->CYCCNT;
+    osTaskNotify(benchTask, 1, OS_NOTIFY_SET_BITS);
+}
+
+static void benchEnableCounter(void){
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+static uint32_t benchOverhead(void){
+    uint32_t start, cycles, best = UINT32_MAX;
+
+    for (uint32_t i = 0; i < OS_BENCH_ITERATIONS; i++)
+    {
+        start = DWT->CYCCNT;
+        cycles = DWT->CYCCNT - start;
+        if (cycles < best) best = cycles;
+    }
+    return best;
+}
+
+#endif // OS_KERNEL_STATS
@@ -0,0 +1,82 @@
+/*
+ * osEventGroup.c
+ *
+ * Grupos de 32 banderas de eventos: una escritura (tarea o ISR) despierta a todas las tareas interesadas.
+ */
+#include <osEventGroup.h>
+#include "osKernel.h"
+
+// Inicializa un grupo de eventos
+void osEventGroupInit(osEventGroupObject* group){
+    group->flags = 0;
+    osTaskListInit(&group->waitList, OS_WAIT_PRIORITY); // Las mas prioritarias leen primero los bits
+}
+
+uint32_t osEventGroupSet(osEventGroupObject* group, const uint32_t bits){
+    uint32_t flags;
+
+    /**
+     * Camino rapido sin tareas esperando: un OR atomico. Si entre LDREX y STREX una tarea se bloquea en
+     * el grupo hubo una excepcion, que limpia el monitor exclusivo y hace fallar STREX.
+     */
+    while (1)
+    {
+        flags = __LDREXW(&group->flags);
+        if (group->waitList.head != NULL)
+        {
+            __CLREX();
+            break;
+        }
+        if (__STREXW(flags | bits, &group->flags) == 0) return flags | bits;
+    }
+
+    osEnterCriticalSection();
+
+    group->flags |= bits;
+    checkBlockedTaskFromEventGroup(group);
+    flags = group->flags;
+
+    osExitCriticalSection();
+    return flags;
+}
+
+uint32_t osEventGroupClear(osEventGroupObject* group, const uint32_t bits){
+    uint32_t flags;
+
+    // Borrar bits no cumple ninguna espera: alcanza con el AND atomico
+    do
+    {
+        flags = __LDREXW(&group->flags);
+    } while (__STREXW(flags & ~bits, &group->flags) != 0);
+
+    return flags;
+}
+
+uint32_t osEventGroupGet(osEventGroupObject* group){
+    return group->flags;
+}
+
+osResultType osEventGroupWait(osEventGroupObject* group, const uint32_t mask, const uint32_t options, uint32_t* flags, const uint32_t timeout){
+    osResultType result = OS_OK;
+    uint32_t value;
+
+    if (mask == 0) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    value = group->flags;
+    if ((options & OS_EVENT_WAIT_ALL) ? ((value & mask) == mask) : ((value & mask) != 0))
+    {
+        if (options & OS_EVENT_CLEAR_ON_EXIT) group->flags &= ~mask;
+    }
+    else
+    {
+        // Si la despierta un set, este ya borro los bits (con OS_EVENT_CLEAR_ON_EXIT) y le dejo el valor que la cumplio
+        result = blockTaskFromEventGroup(group, mask, options, &value, timeout);
+    }
+
+    osExitCriticalSection();
+
+    if (flags != NULL) *flags = value;
+    return result;
+}
@@ -8,6 +8,30 @@
 #include "osIRQ.h"
 #include "osKernel.h"//**
 
+#if (OS_IRQ_DEFER_QUEUE_SIZE & (OS_IRQ_DEFER_QUEUE_SIZE - 1)) != 0
+#error "OS_IRQ_DEFER_QUEUE_SIZE must be a power of two"
+#endif
+
+typedef struct
+{
+	IRQHandler  function;   // Bottom half, NULL while the slot is free or still being written.
+	void*       data;
+}osIRQWork;
+
+#if OS_USE_IRQ_WORKER
+static osIRQWork irqWork[OS_IRQ_DEFER_QUEUE_SIZE];
+static volatile uint32_t irqWorkWrite = 0;      // Slots reserved by the top halves (free running)
+static volatile uint32_t irqWorkRead = 0;       // Slots drained by the worker task (free running)
+
+static osTaskObject irqWorkerTask;
+static uint32_t irqWorkerStack[OS_IRQ_WORKER_STACK_SIZE/4] OS_STACK_ALIGN;
+
+/**
+ * @brief Worker task: runs the deferred bottom halves in order and sleeps while the queue is empty.
+ */
+static void irqWorkerHandler(void);
+#endif
+
 
 bool osRegisterIRQ(osIRQnType irqType, IRQHandler function, void *data)
 {
@@ -43,3 +67,70 @@ bool osUnregisterIRQ(osIRQnType irqType)
     return true;
 }
 
+#if OS_USE_IRQ_WORKER
+bool osIRQDefer(IRQHandler function, void *data)
+{
+    uint32_t write;
+
+    if (function == NULL) return false;
+
+    /**
+     * Reserves a slot with LDREX/STREX. A nested interrupt that defers in between clears the exclusive
+     * monitor and the outer one retries with the next slot, so several top halves never share a slot.
+     */
+    do
+    {
+        write = __LDREXW(&irqWorkWrite);
+        if (write - irqWorkRead >= OS_IRQ_DEFER_QUEUE_SIZE)
+        {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(write + 1, &irqWorkWrite) != 0);
+
+    // The function is published last: the worker only takes the slot once it is complete
+    irqWork[write & (OS_IRQ_DEFER_QUEUE_SIZE - 1)].data = data;
+    __DMB();
+    irqWork[write & (OS_IRQ_DEFER_QUEUE_SIZE - 1)].function = function;
+
+    osTaskNotify(&irqWorkerTask, 0, OS_NOTIFY_NO_ACTION);
+    return true;
+}
+
+bool osIRQWorkerInit(void)
+{
+    return osTaskCreateEx(&irqWorkerTask, OS_IRQ_WORKER_PRIORITY, irqWorkerHandler, irqWorkerStack, OS_IRQ_WORKER_STACK_SIZE, OS_TASK_FLAG_NONE);
+}
+
+static void irqWorkerHandler(void)
+{
+    osIRQWork* work;
+    IRQHandler function;
+    void* data;
+
+    while (1)
+    {
+        // Slots are drained in reservation order; a reserved slot not yet published stops the drain
+        while ((function = (work = &irqWork[irqWorkRead & (OS_IRQ_DEFER_QUEUE_SIZE - 1)])->function) != NULL)
+        {
+            data = work->data;
+            work->function = NULL;
+            __DMB();
+            irqWorkRead++;
+
+            function(data);
+        }
+
+        // A top half that defers after the drain leaves the notification pending: the wait returns at once
+        osTaskNotifyWait(0, 0, NULL, OS_MAX_DELAY);
+    }
+}
+#else
+bool osIRQDefer(IRQHandler function, void *data)
+{
+    // Without the worker task nobody would run the bottom half
+    (void)function;
+    (void)data;
+    return false;
+}
+#endif
@@ -4,10 +4,16 @@
  * @brief Funciones principales del sistema operativo.
  */
 #include "../../OS/Inc/osKernel.h"
+#include "osIRQ.h"
 
-#define IDLEPRIORIRY 100
+#define IDLEPRIORIRY MAX_PRIORITY     // La idle ocupa su propio nivel, debajo de OS_LOW_PRIORITY
 
 osTaskObject idle;
+static uint32_t idleStack[OS_IDLE_STACK_SIZE/4] OS_STACK_ALIGN;
+static uint32_t osStartContext[32] OS_STACK_ALIGN;  // Descarte del contexto de main en el primer PendSV (R4-R11, LR, S16-S31)
+#if OS_STACK_POOL_TASKS > 0
+static uint32_t osStackPool[OS_STACK_POOL_TASKS][MAX_STACK_SIZE/4] OS_STACK_ALIGN;
+#endif
 uint8_t osTasksCreated = 0;
 uint8_t currentTaskIndex = 0;
 
@@ -22,7 +28,10 @@ typedef struct {
         osTaskObject* osListTask[MAX_TASKS];    ///< Lista de tareas
         OsStatus osStatus;                      ///< Estado actual del sistema operativo
 //---CR
-        osTaskObject* osTaskPriorityList[MAX_TASKS];///< Lista de prioridades de tareas
+        osTaskListObject osReadyList[MAX_PRIORITY + 1];///< Tareas listas, una cola FIFO por prioridad (idle incluida)
+        uint32_t osReadyMask;                   ///< Bit (31 - prioridad) en 1 si la cola de esa prioridad no esta vacia
+        uint32_t osTickCount;                   ///< Ticks transcurridos desde osStart()
+        osTaskObject* osDelayList;              ///< Tareas dormidas, la cabeza es la proxima en despertar
         bool inISRContext; // rastreamos si el SO usa sem o queue desde ISR
 //---
 
@@ -30,46 +39,120 @@ typedef struct {
 
 static osKernelObject OsKernel;
 
+#if OS_KERNEL_STATS
+static osKernelStatsObject OsKernelStats;
+static osTaskObject* preemptTask;           // Tarea despertada que debe desalojar a la actual
+static uint32_t preemptStamp;               // CYCCNT al momento de despertarla
+static uint32_t delayCount;                 // Tareas en la lista de dormidas
+#endif
+
 
 // Declaración de funciones
 /**
  * @brief Planificador de tareas.
  */
 	static void scheduler(void);
+#if OS_KERNEL_STATS
+	/**
+	 * @brief Recorrido lineal de todas las tareas, como hacia el scheduler antes de la mascara de listas.
+	 *        Solo se usa para comparar ciclos con la busqueda por __CLZ.
+	 * @return Prioridad mas alta con alguna tarea lista.
+	 */
+	static uint32_t schedulerLinearScan(void);
+#endif
+	/**
+	 * @brief Rota la cola de la prioridad de la tarea actual (round robin en cada tick).
+	 */
+	static void roundRobin(void);
+	/**
+	 * @brief Inicializa el stack frame y los campos de una tarea y la encola como lista.
+	 */
+	static void taskInit(osTaskObject* handler, osPriorityType priority, void* taskCallback, uint32_t* stack, uint32_t stackSize, uint32_t flags);
+	/**
+	 * @brief Pasa una tarea a OS_TASK_READY y la agrega al final de la cola de su prioridad.
+	 */
+	static void taskSetReady(osTaskObject* task);
+	/**
+	 * @brief Pasa una tarea a OS_TASK_BLOCK y la quita de la cola de listas.
+	 */
+	static void taskSetBlocked(osTaskObject* task);
+	/**
+	 * @brief Cambia la prioridad efectiva de una tarea y la reubica en la lista en la que este.
+	 */
+	static void taskSetPriority(osTaskObject* task, osPriorityType priority);
+	/**
+	 * @brief Agrega una tarea a una lista respetando su orden (FIFO o por prioridad).
+	 */
+	static void taskListInsert(osTaskListObject* list, osTaskObject* task);
+	/**
+	 * @brief Quita una tarea de la lista en la que esta enlazada.
+	 */
+	static void taskListRemove(osTaskListObject* list, osTaskObject* task);
+	/**
+	 * @brief Bloquea la tarea actual en la lista de espera de un objeto hasta que la despierten o venza el timeout.
+	 *        Con list NULL solo la puede despertar el timeout o un wakeTask directo.
+	 * @return taskWaitResult al despertar, u OS_WOULD_BLOCK si la tarea no puede bloquearse.
+	 */
+	static osResultType blockTaskOnList(osTaskListObject* list, uint32_t timeout);
+	/**
+	 * @brief Despierta la primera tarea de la lista de espera de un objeto.
+	 * @return Tarea despertada o NULL si la lista estaba vacia.
+	 */
+	static osTaskObject* wakeTaskFromList(osTaskListObject* list);
+	/**
+	 * @brief Saca una tarea de la lista de espera de un objeto y la deja lista, sin pedir cambio de contexto.
+	 */
+	static void readyWaitingTask(osTaskListObject* list, osTaskObject* task);
+	/**
+	 * @brief Despierta una tarea de la lista de espera de un objeto, este donde este en la lista.
+	 *        Con list NULL despierta a una tarea bloqueada sin objeto (p. ej. en osTaskNotifyWait).
+	 */
+	static void wakeTask(osTaskListObject* list, osTaskObject* task);
+	/**
+	 * @brief Pide un cambio de contexto inmediato si la tarea despertada tiene mas prioridad que la que va a correr.
+	 */
+	static void preemptIfHigherPriority(osTaskObject* task);
 	/**
 	 * @brief Obtiene el contexto de la siguiente tarea.
 	 * @param currentStackPointer Puntero de pila actual.
 	 * @return Puntero de pila de la siguiente tarea.
 	 */
-	static uint32_t getNextContext(uint32_t currentStaskPointer);
-	/**
-	 * @brief Ordena las tareas por prioridad.
-	 * @param task Cantidad de tareas a ordenar.
-	 */
-
-	void taskByPriority(uint8_t task);
+	static uint32_t getNextContext(uint32_t currentStaskPointer, uint32_t execReturn, uint32_t entryCycles);
 	/**
 	 * @brief Gestiona las demoras de las tareas bloqueadas.
 	 */
 	void manageTaskDelays(void);
 	/**
-	 * @brief Encuentra la tarea bloqueada por un semáforo.
-	 * @param semaphore Puntero al semáforo.
-	 * @return Puntero a la tarea bloqueada o NULL si no se encuentra.
+	 * @brief Inserta una tarea en la lista de dormidas respetando el orden por taskWakeTick.
+	 * @param task Tarea con taskWakeTick ya cargado.
 	 */
-	osTaskObject* findBlockedTaskFromSemaphore(osSemaphoreObject *semaphore);
+	static void delayListInsert(osTaskObject* task);
 	/**
-	 * @brief Encuentra la tarea bloqueada por una cola.
-	 * @param sender Indica si la tarea fue bloqueada por cola llena (0) o cola vacía (1).
-	 * @return Puntero a la tarea bloqueada o NULL si no se encuentra.
+	 * @brief Quita una tarea de la lista de dormidas.
 	 */
-	osTaskObject* findBlockedTaskFromQueue(uint8_t sender);
+	static void delayListRemove(osTaskObject* task);
+#if OS_USE_TICKLESS_IDLE
 	/**
-	 * @brief Obtiene la tarea en ejecución.
-	 * @return Puntero a la tarea en ejecución o NULL si no hay ninguna.
+	 * @brief Ticks hasta el vencimiento de osDelay mas cercano.
+	 * @return Ticks restantes, o OS_MAX_DELAY si ninguna tarea espera por tiempo.
 	 */
-
-	osTaskObject* getRunningTask(void);
+	static uint32_t getNextWakeTicks(void);
+	/**
+	 * @brief Compensa los ticks transcurridos con el SysTick suprimido.
+	 * @param ticks Ticks completos dormidos.
+	 */
+	static void stepTickCount(uint32_t ticks);
+#endif
+	/**
+	 * @brief Obtiene la tarea en ejecución que puede bloquearse.
+	 * @return La tarea actual, o NULL si el SO no arranco o se llama desde una ISR.
+	 */
+	static osTaskObject* getRunningTask(void);
+	/**
+	 * @brief Espera de notificacion comun a osTaskNotifyWait y osTaskNotifyWaitUntil.
+	 * @param ticks Timeout relativo, o tick absoluto de vencimiento si absolute es true.
+	 */
+	static osResultType taskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, uint32_t ticks, bool absolute);
 	/**
 	 * @brief Realiza un cambio de contexto forzado.
 	 */
@@ -77,16 +160,42 @@ static osKernelObject OsKernel;
 
 // Initializing a task  Step I
 
+#if OS_STACK_POOL_TASKS > 0
 bool osTaskCreate(osTaskObject* handler, osPriorityType priority, void* taskCallback)
+{
+    static uint8_t osStackPoolUsed = 0;
+
+    if (osStackPoolUsed >= OS_STACK_POOL_TASKS) return false;
+
+    if (!osTaskCreateEx(handler, priority, taskCallback, osStackPool[osStackPoolUsed], MAX_STACK_SIZE, OS_TASK_FLAG_NONE))
+    {
+        return false;
+    }
+    osStackPoolUsed++;
+    return true;
+}
+#endif
+
+bool osTaskCreateEx(osTaskObject* handler, osPriorityType priority, void* taskCallback, uint32_t* stack, uint32_t stackSize, uint32_t flags)
 {
 	//==== *variableInitialization*  on taskInit===
     static uint8_t osTaskCount = 0;
 
-    if (taskCallback == NULL || handler == NULL) {
-        // Manejo de error si taskCallback o handler son NULL
+    if (taskCallback == NULL || handler == NULL || priority >= MAX_PRIORITY) {
+        // Manejo de error si taskCallback o handler son NULL, o la prioridad es la reservada para idle
         return false; // O toma otra acción de manejo de errores
     }
 
+    // El stack frame se arma desde el final del buffer: base y tamaño multiplos de 8 dejan el SP alineado
+    if (stack == NULL || ((uint32_t)stack & 0x7U) != 0 || (stackSize & 0x7U) != 0 || stackSize < MIN_STACK_SIZE) {
+        return false;
+    }
+
+    // Una tarea con FPU puede ser desalojada con el stack frame extendido y S16-S31
+    if ((flags & OS_TASK_FLAG_FPU) && stackSize < MIN_STACK_SIZE + FPU_CONTEXT_SIZE) {
+        return false;
+    }
+
     //=== end *variableInitialization* taskInit===
     if (osTaskCount == 0) //-- if is the first time, initialize array with NUll
     {
@@ -101,16 +210,7 @@ bool osTaskCreate(osTaskObject* handler, osPriorityType priority, void* taskCall
     }
     //== end else if
 
-    //===initialization of *taskObject*
-    handler->memory[MAX_STACK_SIZE/4 - XPSR_REG_POSITION] = XPSR_VALUE;//1 << 24     // xPSR.T = 1
-    handler->memory[MAX_STACK_SIZE/4 - PC_REG_POSTION] = (uint32_t)taskCallback; // address
-    handler->memory[MAX_STACK_SIZE/4 - LR_PREV_VALUE_POSTION] = EXEC_RETURN_VALUE; // 0xFFFFFFF9
-    handler->taskStackPointer = (uint32_t)(handler->memory + MAX_STACK_SIZE/4 - STACK_FRAME_SIZE);
-    handler->taskEntryPoint = taskCallback;
-    handler->taskExecStatus = OS_TASK_READY;
-    handler->taskPriority = priority;
-    handler->taskTickCounter = 0;
-    //===end initialization of *taskObject*
+    taskInit(handler, priority, taskCallback, stack, stackSize, flags);
 
     OsKernel.osListTask[osTaskCount] = handler; // -- storage pointer object handler
     handler->taskID = osTaskCount;
@@ -119,23 +219,64 @@ bool osTaskCreate(osTaskObject* handler, osPriorityType priority, void* taskCall
     return true;
 }
 
+static void taskInit(osTaskObject* handler, osPriorityType priority, void* taskCallback, uint32_t* stack, uint32_t stackSize, uint32_t flags)
+{
+    uint32_t* stackTop = stack + stackSize/4;
+
+    //===initialization of *taskObject*
+    handler->taskStackBase = stack;
+    handler->taskStackSize = stackSize;
+    stackTop[-XPSR_REG_POSITION] = XPSR_VALUE;//1 << 24     // xPSR.T = 1
+    stackTop[-PC_REG_POSTION] = (uint32_t)taskCallback; // address
+    stackTop[-LR_PREV_VALUE_POSTION] = EXEC_RETURN_VALUE; // 0xFFFFFFFD: thread mode con PSP, sin contexto de FPU
+    handler->taskStackPointer = (uint32_t)(stackTop - STACK_FRAME_SIZE);
+    handler->taskEntryPoint = taskCallback;
+    handler->taskExecStatus = OS_TASK_SUSPENDED;
+    handler->taskPriority = priority;
+    handler->taskBasePriority = priority;
+    handler->taskFlags = flags;
+    handler->taskFpuSwitches = 0;
+    handler->taskWakeTick = 0;
+    handler->taskNext = NULL;
+    handler->taskPrev = NULL;
+    handler->taskWaitList = NULL;
+    handler->taskWaitValue = 0;
+    handler->taskWaitOptions = 0;
+    handler->taskWaitResult = OS_OK;
+    handler->taskNotifyValue = 0;
+    handler->taskNotifyState = OS_NOTIFY_STATE_NONE;
+    handler->taskWaitMutex = NULL;
+    handler->taskMutexList = NULL;
+    handler->delayNext = NULL;
+    handler->delayPrev = NULL;
+    //===end initialization of *taskObject*
+
+    taskSetReady(handler);
+}
+
 
 // Operating system startup Step II
 
 void osStart(void)
 {
+#if OS_USE_TIMERS
+    // La tarea de timers es una tarea mas: se crea antes de contar las tareas
+    if (!osTimerServiceInit()) osErrorHook(osStart);
+#endif
+#if OS_USE_IRQ_WORKER
+    if (!osIRQWorkerInit()) osErrorHook(osStart);
+#endif
+
     //== iterate and count valid addresses in the list
     for (uint8_t i = 0; i < MAX_TASKS - 1; i++)
     {
         if (NULL != OsKernel.osListTask[i]) osTasksCreated++;
     }
 
-    // == order tasks first high priority tasks
-    taskByPriority(osTasksCreated);
-    // == end order
-
-    // idle tasks initialization
-    osTaskCreate(&idle, IDLEPRIORIRY, osIdleTask);
+    // idle tasks initialization: queda siempre en la cola IDLEPRIORIRY, la mascara de listas nunca es cero
+    taskInit(&idle, IDLEPRIORIRY, osIdleTask, idleStack, OS_IDLE_STACK_SIZE, OS_TASK_FLAG_NONE);
+    OsKernel.osListTask[osTasksCreated] = &idle;
+    idle.taskID = osTasksCreated;
 
     NVIC_DisableIRQ(SysTick_IRQn);
     NVIC_DisableIRQ(PendSV_IRQn);
@@ -145,8 +286,29 @@ void osStart(void)
     OsKernel.osCurrentTaskCallback = NULL;
     OsKernel.osNextTaskCallback = NULL;
     OsKernel.inISRContext = false;
+    OsKernel.osTickCount = 0;
+    OsKernel.osDelayList = NULL;
     NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
 
+#if (__FPU_PRESENT == 1) && (__FPU_USED == 1)
+    /**
+     * Lazy stacking: ASPEN hace que solo las tareas que ejecutaron una instruccion de FPU desde su ultimo
+     * turno (CONTROL.FPCA) tengan stack frame extendido; LSPEN difiere el guardado de S0-S15 hasta que
+     * alguien vuelve a usar la FPU. Las tareas enteras conservan el frame de 17 palabras.
+     */
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
+
+    // main corre sobre el MSP, que desde aca queda para handlers; el PSP recibe el primer contexto descartado
+    __set_PSP((uint32_t)(osStartContext + sizeof(osStartContext)/sizeof(osStartContext[0])));
+
+#if OS_KERNEL_STATS
+    // Habilita el contador de ciclos del DWT para medir el scheduler
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     SystemCoreClockUpdate();
     SysTick_Config(SystemCoreClock / OS_SYSTICK_TICK);
 
@@ -157,7 +319,7 @@ void osStart(void)
 
 // Function para obtener el siguiente contexto
 
-static uint32_t getNextContext(uint32_t currentStackPointer)
+static uint32_t getNextContext(uint32_t currentStackPointer, uint32_t execReturn, uint32_t entryCycles)
 {
     // Si es la primera vez que se ejecuta el sistema operativo
     if (OsKernel.osStatus != OS_STATUS_RUNNING)
@@ -173,21 +335,43 @@ static uint32_t getNextContext(uint32_t currentStackPointer)
     // Almacena el último puntero de pila utilizado en la tarea actual y cambia su estado a lista para ejecutar
     OsKernel.osCurrentTaskCallback->taskStackPointer = currentStackPointer;
 
-    // Verifica si la tarea actual estaba bloqueada y tiene un contador de tiempo pendiente
-    if (OsKernel.osCurrentTaskCallback->taskTickCounter != 0 && OsKernel.osCurrentTaskCallback->taskExecStatus == OS_TASK_BLOCK)
+    // EXEC_RETURN[4] = 0: la tarea uso la FPU desde su ultimo turno y PendSV guardo su contexto de FPU
+    if ((execReturn & 0x10U) == 0)
     {
-        // la tarea permanece bloqueada
+        OsKernel.osCurrentTaskCallback->taskFpuSwitches++;
+#if OS_FPU_STRICT
+        if (!(OsKernel.osCurrentTaskCallback->taskFlags & OS_TASK_FLAG_FPU)) osErrorHook(OsKernel.osCurrentTaskCallback);
+#endif
     }
-    else
+
+#if OS_KERNEL_STATS
+    if ((execReturn & 0x10U) == 0) OsKernelStats.switchSaveFpuCycles = DWT->CYCCNT - entryCycles;
+    else                           OsKernelStats.switchSaveCycles = DWT->CYCCNT - entryCycles;
+#else
+    (void)entryCycles;
+#endif
+
+    // Si la tarea se bloqueo ya salio de su cola; si no, sigue encolada y solo cambia de estado
+    if (OsKernel.osCurrentTaskCallback->taskExecStatus == OS_TASK_RUNNING)
     {
-        // Establece el estado de la tarea actual como lista para ejecutar
         OsKernel.osCurrentTaskCallback->taskExecStatus = OS_TASK_READY;
     }
 
-    // Cambia a la siguiente tarea en la cola y cambia su estado a en ejecución
+    // Cambia a la siguiente tarea en la cola y cambia su estado a en ejecución. Solo getNextContext pasa
+    // una tarea a OS_TASK_RUNNING, y siempre es la que queda en osCurrentTaskCallback
     OsKernel.osCurrentTaskCallback = OsKernel.osNextTaskCallback;
     OsKernel.osCurrentTaskCallback->taskExecStatus = OS_TASK_RUNNING;
 
+#if OS_KERNEL_STATS
+    if (preemptTask == OsKernel.osCurrentTaskCallback)
+    {
+        uint32_t cycles = DWT->CYCCNT - preemptStamp;
+        OsKernelStats.wakeLatencyLastCycles = cycles;
+        if (cycles > OsKernelStats.wakeLatencyMaxCycles) OsKernelStats.wakeLatencyMaxCycles = cycles;
+        preemptTask = NULL;
+    }
+#endif
+
     // Devuelve el puntero de pila de la tarea actual (que ahora está en ejecución)
     return OsKernel.osCurrentTaskCallback->taskStackPointer;
 }
@@ -195,89 +379,227 @@ static uint32_t getNextContext(uint32_t currentStackPointer)
 // Task scheduling function Step IV
 static void scheduler(void)
 {
-    static uint8_t osTaskIndex = 0;
-	static uint8_t status[MAX_TASKS];
-	osTaskStatusType taskStatus;
-	uint8_t numBlockedTasks = 0;
+    uint32_t priority;
 
+#if OS_KERNEL_STATS
+    uint32_t cycles = DWT->CYCCNT;
+#endif
+
+    // La prioridad mas alta con tareas listas es la cantidad de ceros a la izquierda de la mascara
+    priority = __CLZ(OsKernel.osReadyMask);
 
     if (OsKernel.osStatus != OS_STATUS_RUNNING)
     {
-        OsKernel.osCurrentTaskCallback = OsKernel.osListTask[0];
+        OsKernel.osCurrentTaskCallback = OsKernel.osReadyList[priority].head;
         return;
     }
 
+    OsKernel.osNextTaskCallback = OsKernel.osReadyList[priority].head;
 
+#if OS_KERNEL_STATS
+    cycles = DWT->CYCCNT - cycles;
+    OsKernelStats.schedulerLastCycles = cycles;
+    if (cycles > OsKernelStats.schedulerMaxCycles) OsKernelStats.schedulerMaxCycles = cycles;
 
-	for (uint8_t taskIndex = 0; taskIndex < osTasksCreated; taskIndex++)
-	{
-		if (OsKernel.osListTask[taskIndex]->taskExecStatus == OS_TASK_BLOCK)
-		{
-			numBlockedTasks++;
-		}
-	}
-
-	if (numBlockedTasks == osTasksCreated)
-	{
-		if (OsKernel.osCurrentTaskCallback != OsKernel.osListTask[osTasksCreated])
-		{
-			OsKernel.osNextTaskCallback = OsKernel.osListTask[osTasksCreated];
-
-			osTaskIndex = osTasksCreated;
-		}
-		return;
-	}
-
-	for (uint8_t taskIndex = 0; taskIndex < osTasksCreated; taskIndex++)
-	{
-		taskStatus = OsKernel.osListTask[taskIndex]->taskExecStatus;
-		switch(taskStatus)
-		{
-			case OS_TASK_READY:
-			{
-				if (osTasksCreated == 1 || taskIndex > osTaskIndex)
-				{
-				    OsKernel.osNextTaskCallback = OsKernel.osListTask[taskIndex];
-				    osTaskIndex = taskIndex;
-				    return;
-				}
-
-				for (uint8_t blockedTaskIndex = 0; blockedTaskIndex < osTasksCreated; blockedTaskIndex++)
-				{
-				    if (status[blockedTaskIndex] == 1 && OsKernel.osListTask[taskIndex]->taskExecStatus == OS_TASK_READY)
-				    {
-				        OsKernel.osNextTaskCallback = OsKernel.osListTask[taskIndex];
-				        status[blockedTaskIndex] = 0;
-				        osTaskIndex = taskIndex;
-				        return;
-				    }
-				}
-
-			}
-			break;
-			case OS_TASK_RUNNING:
-			{
-				if (osTaskIndex == osTasksCreated - 1)
-				{
-					osTaskIndex = 0;
-					OsKernel.osNextTaskCallback = OsKernel.osListTask[osTaskIndex];
-				}
-			}
-			break;
-			case OS_TASK_BLOCK:
-			{
-			    status[taskIndex] = (taskIndex <= osTaskIndex) ? 1 : 0;
-
-			}
-			break;
-			case OS_TASK_SUSPENDED: break;
-
-
-
-
-		}
-	}
+    // Referencia: el recorrido lineal sobre el mismo estado, que ademas tiene que elegir la misma prioridad
+    cycles = DWT->CYCCNT;
+    if (schedulerLinearScan() != priority) osErrorHook(scheduler);
+    cycles = DWT->CYCCNT - cycles;
+    OsKernelStats.schedulerScanLastCycles = cycles;
+    if (cycles > OsKernelStats.schedulerScanMaxCycles) OsKernelStats.schedulerScanMaxCycles = cycles;
+#endif
+}
 
+#if OS_KERNEL_STATS
+static uint32_t schedulerLinearScan(void)
+{
+    uint32_t priority = IDLEPRIORIRY;
+    osTaskObject* task;
+
+    // osListTask[osTasksCreated] es la idle: se recorren todas, sin cortar en la primera lista
+    for (uint8_t i = 0; i <= osTasksCreated; i++)
+    {
+        task = OsKernel.osListTask[i];
+        if ((task->taskExecStatus == OS_TASK_READY || task->taskExecStatus == OS_TASK_RUNNING) && task->taskPriority < priority)
+        {
+            priority = task->taskPriority;
+        }
+    }
+    return priority;
+}
+#endif
+
+static void roundRobin(void)
+{
+    osTaskObject* task = OsKernel.osCurrentTaskCallback;
+    osTaskListObject* list;
+
+    if (task == NULL || task->taskExecStatus != OS_TASK_RUNNING) return;
+
+    // La tarea en ejecucion es la cabeza de su cola: pasa al final si tiene pares listos
+    list = &OsKernel.osReadyList[task->taskPriority];
+    if (list->head == task && list->tail != task)
+    {
+        taskListRemove(list, task);
+        taskListInsert(list, task);
+    }
+}
+
+void osTaskListInit(osTaskListObject* list, osWaitOrderType order)
+{
+    list->head = NULL;
+    list->tail = NULL;
+    list->order = order;
+}
+
+static void taskListInsert(osTaskListObject* list, osTaskObject* task)
+{
+    osTaskObject* next = NULL;
+
+    // Por prioridad: antes de la primera de menor prioridad. El recorrido esta acotado por MAX_TASKS
+    if (list->order == OS_WAIT_PRIORITY)
+    {
+        next = list->head;
+        while (next != NULL && next->taskPriority <= task->taskPriority) next = next->taskNext;
+    }
+
+    task->taskNext = next;
+    task->taskPrev = (next != NULL) ? next->taskPrev : list->tail;
+    if (task->taskPrev != NULL) task->taskPrev->taskNext = task;
+    else                        list->head = task;
+    if (next != NULL)           next->taskPrev = task;
+    else                        list->tail = task;
+}
+
+static void taskListRemove(osTaskListObject* list, osTaskObject* task)
+{
+    if (task->taskPrev != NULL) task->taskPrev->taskNext = task->taskNext;
+    else                        list->head = task->taskNext;
+    if (task->taskNext != NULL) task->taskNext->taskPrev = task->taskPrev;
+    else                        list->tail = task->taskPrev;
+    task->taskNext = NULL;
+    task->taskPrev = NULL;
+}
+
+static void taskSetReady(osTaskObject* task)
+{
+    if (task->taskExecStatus == OS_TASK_READY || task->taskExecStatus == OS_TASK_RUNNING) return;
+
+    taskListInsert(&OsKernel.osReadyList[task->taskPriority], task);
+    OsKernel.osReadyMask |= (0x80000000U >> task->taskPriority);
+    task->taskExecStatus = OS_TASK_READY;
+}
+
+static void taskSetBlocked(osTaskObject* task)
+{
+    osTaskListObject* list;
+
+    if (task->taskExecStatus == OS_TASK_READY || task->taskExecStatus == OS_TASK_RUNNING)
+    {
+        list = &OsKernel.osReadyList[task->taskPriority];
+        taskListRemove(list, task);
+        if (list->head == NULL) OsKernel.osReadyMask &= ~(0x80000000U >> task->taskPriority);
+    }
+    task->taskExecStatus = OS_TASK_BLOCK;
+}
+
+static void taskSetPriority(osTaskObject* task, osPriorityType priority)
+{
+    osTaskListObject* list = NULL;
+
+    if (task->taskPriority == priority) return;
+
+    // Lista o en ejecucion: cambia de cola de listas, al final de la nueva
+    if (task->taskExecStatus == OS_TASK_READY || task->taskExecStatus == OS_TASK_RUNNING)
+    {
+        list = &OsKernel.osReadyList[task->taskPriority];
+        taskListRemove(list, task);
+        if (list->head == NULL) OsKernel.osReadyMask &= ~(0x80000000U >> task->taskPriority);
+        task->taskPriority = priority;
+        taskListInsert(&OsKernel.osReadyList[priority], task);
+        OsKernel.osReadyMask |= (0x80000000U >> priority);
+        return;
+    }
+
+    // Bloqueada en una lista por prioridad: se reubica para que la despierten en el orden correcto
+    if (task->taskWaitList != NULL && task->taskWaitList->order == OS_WAIT_PRIORITY) list = task->taskWaitList;
+
+    if (list != NULL) taskListRemove(list, task);
+    task->taskPriority = priority;
+    if (list != NULL) taskListInsert(list, task);
+}
+
+static osResultType blockTaskOnList(osTaskListObject* list, uint32_t timeout)
+{
+    osTaskObject *task = getRunningTask();
+
+    if (task == NULL || timeout == 0) return OS_WOULD_BLOCK;
+
+    // Mas alla de OS_MAX_TIMEOUT la resta con signo de la lista de dormidas lo daria por vencido
+    if (timeout != OS_MAX_DELAY && timeout > OS_MAX_TIMEOUT) timeout = OS_MAX_TIMEOUT;
+
+    taskSetBlocked(task);
+    if (list != NULL) taskListInsert(list, task);
+    task->taskWaitList = list;
+    task->taskWaitResult = OS_TIMEOUT;
+
+    // Con timeout finito tambien queda en la lista de dormidas: la despierta lo que ocurra primero
+    if (timeout != OS_MAX_DELAY)
+    {
+        task->taskWakeTick = OsKernel.osTickCount + timeout;
+        delayListInsert(task);
+    }
+
+    osYield();
+
+    // El cambio de contexto ocurre al habilitar las interrupciones; se vuelve aca ya despierta
+    osExitCriticalSection();
+    osEnterCriticalSection();
+
+    return task->taskWaitResult;
+}
+
+static osTaskObject* wakeTaskFromList(osTaskListObject* list)
+{
+    osTaskObject *task = list->head;
+
+    if (task != NULL) wakeTask(list, task);
+    return task;
+}
+
+static void readyWaitingTask(osTaskListObject* list, osTaskObject* task)
+{
+    if (list != NULL) taskListRemove(list, task);
+    task->taskWaitList = NULL;
+    task->taskWaitResult = OS_OK;
+    delayListRemove(task);
+    taskSetReady(task);
+}
+
+static void wakeTask(osTaskListObject* list, osTaskObject* task)
+{
+    readyWaitingTask(list, task);
+    preemptIfHigherPriority(task);
+}
+
+static void preemptIfHigherPriority(osTaskObject* task)
+{
+    osTaskObject* next = OsKernel.osNextTaskCallback;
+
+    // Se compara con la tarea ya elegida (la actual, o la que la reemplaza si hay un PendSV pendiente).
+    // A igual o menor prioridad la despertada espera su turno en la cola, sin cambio de contexto.
+    if (next != NULL && next->taskExecStatus != OS_TASK_BLOCK && task->taskPriority >= next->taskPriority)
+    {
+        return;
+    }
+
+#if OS_KERNEL_STATS
+    preemptTask = task;
+    preemptStamp = DWT->CYCCNT;
+#endif
+
+    // Desde una tarea cambia al volver de osYield; desde una ISR, al salir de osIRQHandler
+    osYield();
 }
 
 
@@ -285,6 +607,21 @@ __attribute__ ((naked)) void PendSV_Handler(void)
 {
     // Se entra a la seccion critica y se deshabilita las interrupciones.
 	__ASM volatile ("cpsid i");
+
+#if OS_KERNEL_STATS
+    // R2 (tercer argumento de getNextContext) = DWT->CYCCNT a la entrada, para medir el guardado del contexto
+    __ASM volatile ("movw r2, #0x1004");
+    __ASM volatile ("movt r2, #0xE000");
+    __ASM volatile ("ldr r2, [r2]");
+#endif
+
+    /**
+     * Las tareas corren en modo thread sobre el PSP y los handlers (incluido este) sobre el MSP. El
+     * hardware ya apilo el stack frame basico de la tarea en su PSP, asi que el resto del contexto
+     * se guarda a mano en ese mismo stack a traves de R0.
+     */
+    __ASM volatile ("mrs r0, psp");
+
     /**
      * Implementación de stacking para FPU:
      *
@@ -292,41 +629,41 @@ __attribute__ ((naked)) void PendSV_Handler(void)
      * AND estilo bitwise (bit a bit) entre el registro LR y el literal inmediato. El resultado de esta
      * operacion no se guarda y los bits N y Z son actualizados. En este caso, si el bit EXEC_RETURN[4] = 0
      * el resultado de la operacion sera cero, y la bandera Z = 1, por lo que se da la condicion EQ y
-     * se hace el push de los registros de FPU restantes
+     * se guardan los registros de FPU restantes en el stack de la tarea
      */
     __ASM volatile ("tst lr, 0x10");
     __ASM volatile ("it eq");
-    __ASM volatile ("vpusheq {s16-s31}");
+    __ASM volatile ("vstmdbeq r0!, {s16-s31}");
 
     /**
-     * Cuando se ingresa al handler de PendSV lo primero que se ejecuta es un push para
-	 * guardar los registros R4-R11 y el valor de LR, que en este punto es EXEC_RETURN
-	 * El push se hace al reves de como se escribe en la instruccion, por lo que LR
-	 * se guarda en la posicion 9 (luego del stack frame). Como la funcion getNextContext
-	 * se llama con un branch con link, el valor del LR es modificado guardando la direccion
-	 * de retorno una vez se complete la ejecucion de la funcion
+     * Se guardan R4-R11 y el valor de LR, que en este punto es EXEC_RETURN, con la misma disposicion
+     * que dejaba el push: LR queda en la posicion 9 (luego del stack frame). Como la funcion
+     * getNextContext se llama con un branch con link, el valor del LR es modificado guardando la
+     * direccion de retorno una vez se complete la ejecucion de la funcion
 	 * El pasaje de argumentos a getContextoSiguiente se hace como especifica el AAPCS siendo
 	 * el unico argumento pasado por RO, y el valor de retorno tambien se almacena en R0
 	 *
-	 * NOTA: El primer ingreso a este handler (luego del reset) implica que el push se hace sobre el
-	 * stack inicial, ese stack se pierde porque no hay seguimiento del MSP en el primer ingreso
+	 * NOTA: En el primer ingreso a este handler (luego del reset) el PSP apunta a osStartContext,
+	 * ese contexto se descarta porque getNextContext no lo registra
      */
-    __ASM volatile ("push {r4-r11, lr}");
-    __ASM volatile ("mrs r0, msp");
+    __ASM volatile ("stmdb r0!, {r4-r11, lr}");
+    __ASM volatile ("mov r1, lr");                  // Segundo argumento: EXEC_RETURN de la tarea saliente
     __ASM volatile ("bl %0" :: "i"(getNextContext));
-    __ASM volatile ("msr msp, r0");
-    __ASM volatile ("pop {r4-r11, lr}");    //Recuperados todos los valores de registros
+    __ASM volatile ("ldmia r0!, {r4-r11, lr}");    //Recuperados todos los valores de registros
 
     /**
      * Implementación de unstacking para FPU:
      *
      * Habiendo hecho el cambio de contexto y recuperado los valores de los registros, es necesario
      * determinar si el contexto tiene guardados registros correspondientes a la FPU. si este es el caso
-     * se hace el unstacking de los que se hizo PUSH manualmente.
+     * se recuperan los que se guardaron a mano.
      */
     __ASM volatile ("tst lr,0x10");
     __ASM volatile ("it eq");
-    __ASM volatile ("vpopeq {s16-s31}");
+    __ASM volatile ("vldmiaeq r0!, {s16-s31}");
+
+    // El PSP queda apuntando al stack frame basico de la nueva tarea, que desapila el hardware
+    __ASM volatile ("msr psp, r0");
 
     // Se sale de la seccion critica y se habilita las interrupciones.
 	__ASM volatile ("cpsie i");
@@ -339,8 +676,30 @@ __attribute__ ((naked)) void PendSV_Handler(void)
 
 void SysTick_Handler(void)
 {
-    scheduler();
+#if OS_KERNEL_STATS
+    uint32_t cycles = DWT->CYCCNT;
+    uint32_t sleeping = delayCount;
+#endif
+
+    // SysTick tiene la menor prioridad: una IRQ que libere tareas no debe cortar la edicion de las listas
+    osEnterCriticalSection();
+    OsKernel.osTickCount++;
     manageTaskDelays();
+    roundRobin();
+    scheduler();
+    osExitCriticalSection();
+
+#if OS_KERNEL_STATS
+    cycles = DWT->CYCCNT - cycles;
+    OsKernelStats.tickLastCycles = cycles;
+    if (cycles > OsKernelStats.tickMaxCycles) OsKernelStats.tickMaxCycles = cycles;
+
+    // Sin vencimientos el tick solo mira la cabeza: el costo no deberia depender de cuantas duermen
+    if (delayCount == sleeping && sleeping < MAX_TASKS && cycles > OsKernelStats.tickIdleMaxCycles[sleeping])
+    {
+        OsKernelStats.tickIdleMaxCycles[sleeping] = cycles;
+    }
+#endif
 
     osSysTickHook();
     SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
@@ -348,59 +707,182 @@ void SysTick_Handler(void)
     __DSB(); //
 }
 
-void taskByPriority(uint8_t task) {
-	    for (uint8_t i = 0; i < task - 1; i++) {
-	        for (uint8_t j = 0; j < task - i - 1; j++) {
-	            if (OsKernel.osListTask[j]->taskPriority > OsKernel.osListTask[j + 1]->taskPriority) {
-	                OsKernel.osListTask[j] = (osTaskObject*)((uintptr_t)OsKernel.osListTask[j] ^ (uintptr_t)OsKernel.osListTask[j + 1]);
-	                OsKernel.osListTask[j + 1] = (osTaskObject*)((uintptr_t)OsKernel.osListTask[j] ^ (uintptr_t)OsKernel.osListTask[j + 1]);
-	                OsKernel.osListTask[j] = (osTaskObject*)((uintptr_t)OsKernel.osListTask[j] ^ (uintptr_t)OsKernel.osListTask[j + 1]);
-	            }
-	        }
-	    }
-}
-
 void manageTaskDelays(void)
 {
-    for (uint8_t i = 0; i < osTasksCreated; i++)
+    osTaskObject *task;
+
+    // Solo se mira la cabeza: las demas tareas vencen despues que ella
+    while ((task = OsKernel.osDelayList) != NULL && (int32_t)(OsKernel.osTickCount - task->taskWakeTick) >= 0)
     {
-        osTaskObject *task = OsKernel.osListTask[i];
+        delayListRemove(task);
+
+        // Vencio el timeout de una espera sobre un objeto: sale tambien de su lista de espera
+        if (task->taskWaitList != NULL)
+        {
+            taskListRemove(task->taskWaitList, task);
+            task->taskWaitList = NULL;
+            task->taskWaitResult = OS_TIMEOUT;
+        }
+        taskSetReady(task);
 
-        if (task->taskExecStatus == OS_TASK_BLOCK && task->taskTickCounter > 0)
+        // Si esperaba un mutex, el dueño (y la cadena de dueños) deja de heredar su prioridad
+        if (task->taskWaitMutex != NULL)
         {
-            task->taskTickCounter--;
+            osMutexObject* mutex = task->taskWaitMutex;
+            osPriorityType priority;
 
-            if (task->taskTickCounter == 0)
+            task->taskWaitMutex = NULL;
+            for (uint32_t depth = 0; mutex != NULL && mutex->owner != NULL && depth < MAX_TASKS; depth++)
             {
-                task->taskExecStatus = OS_TASK_READY;
+                priority = mutex->owner->taskPriority;
+                updateTaskMutexPriority(mutex->owner);
+                if (mutex->owner->taskPriority == priority) break;
+                mutex = mutex->owner->taskWaitMutex;
             }
         }
     }
 }
 
-// Función para bloquear una tarea durante un número de ticks
+static void delayListInsert(osTaskObject* task)
+{
+    osTaskObject *prev = NULL;
+    osTaskObject *next = OsKernel.osDelayList;
 
-void osDelay(const uint32_t tick)
+    // Recorrido acotado por MAX_TASKS; la resta con signo tolera el desborde del contador de ticks
+    while (next != NULL && (int32_t)(next->taskWakeTick - task->taskWakeTick) <= 0)
+    {
+        prev = next;
+        next = next->delayNext;
+    }
+
+    task->delayPrev = prev;
+    task->delayNext = next;
+    if (prev != NULL) prev->delayNext = task;
+    else              OsKernel.osDelayList = task;
+    if (next != NULL) next->delayPrev = task;
+#if OS_KERNEL_STATS
+    delayCount++;
+#endif
+}
+
+static void delayListRemove(osTaskObject* task)
+{
+    if (task->delayPrev != NULL)                  task->delayPrev->delayNext = task->delayNext;
+    else if (OsKernel.osDelayList == task)        OsKernel.osDelayList = task->delayNext;
+    else                                          return;  // No estaba dormida
+    if (task->delayNext != NULL) task->delayNext->delayPrev = task->delayPrev;
+    task->delayNext = NULL;
+    task->delayPrev = NULL;
+#if OS_KERNEL_STATS
+    delayCount--;
+#endif
+}
+
+#if OS_USE_TICKLESS_IDLE
+static uint32_t getNextWakeTicks(void)
 {
+    if (OsKernel.osDelayList == NULL) return OS_MAX_DELAY;
+
+    return OsKernel.osDelayList->taskWakeTick - OsKernel.osTickCount;
+}
+
+static void stepTickCount(uint32_t ticks)
+{
+    // ticks < vencimiento mas cercano: ninguna tarea vence aca, la despierta el SysTick_Handler
+    OsKernel.osTickCount += ticks;
+}
+
+void osTicklessIdle(void)
+{
+    const uint32_t cyclesPerTick = SystemCoreClock / OS_SYSTICK_TICK;
+    const uint32_t maxTicks = SysTick_LOAD_RELOAD_Msk / cyclesPerTick;
+    uint32_t expectedTicks, reloadValue, ctrl, completedCycles, completedTicks;
+
     osEnterCriticalSection();
 
-    osTaskObject *task = NULL;
+    expectedTicks = getNextWakeTicks();
 
-    // Busca la tarea en ejecución
-    for (uint8_t i = 0; i < osTasksCreated; i++)
+    // Solo se suprime el tick si la unica tarea lista es la idle
+    if (OsKernel.osReadyMask != (0x80000000U >> IDLEPRIORIRY) || expectedTicks < OS_TICKLESS_MIN_IDLE_TICKS)
     {
-        if (OsKernel.osListTask[i]->taskExecStatus == OS_TASK_RUNNING)
-        {
-            task = OsKernel.osListTask[i];
-            break;
-        }
+        osExitCriticalSection();
+        __WFI();
+        return;
     }
 
-    if (task != NULL)
+    if (expectedTicks > maxTicks) expectedTicks = maxTicks;
+
+    // Detiene el SysTick; lo que resta del tick en curso mas (expectedTicks - 1) ticks completos
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    reloadValue = SysTick->VAL + cyclesPerTick * (expectedTicks - 1);
+
+    // Si el tick vencio mientras se detenia, se retoma el periodo normal y lo atiende su handler
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
     {
-        // Bloquea la tarea actual y establece el contador de ticks
-        task->taskExecStatus = OS_TASK_BLOCK;
-        task->taskTickCounter = tick;
+        SysTick->LOAD = SysTick->VAL;
+        SysTick->VAL = 0;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        SysTick->LOAD = cyclesPerTick - 1;
+        osExitCriticalSection();
+        return;
+    }
+
+    SysTick->LOAD = reloadValue;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    HAL_SuspendTick();                      // La base de tiempos de la HAL (TIM1) tambien despierta cada 1 ms
+
+    // Con las interrupciones deshabilitadas WFI igual despierta ante una interrupcion pendiente
+    __DSB();
+    __WFI();
+    __ISB();
+
+    HAL_ResumeTick();
+
+    // Leer CTRL borra COUNTFLAG: se lee una sola vez
+    ctrl = SysTick->CTRL;
+    SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+
+    if (ctrl & SysTick_CTRL_COUNTFLAG_Msk)
+    {
+        // Vencio el SysTick: el handler pendiente cuenta el ultimo tick y despierta a la tarea
+        completedCycles = reloadValue - SysTick->VAL;
+        SysTick->LOAD = (completedCycles < cyclesPerTick - 1) ? (cyclesPerTick - 1) - completedCycles : cyclesPerTick - 1;
+        completedTicks = expectedTicks - 1;
+    }
+    else
+    {
+        // Desperto otra interrupcion: se cuentan los ticks enteros y se completa el tick en curso
+        completedCycles = expectedTicks * cyclesPerTick - SysTick->VAL;
+        completedTicks = completedCycles / cyclesPerTick;
+        if (completedTicks >= expectedTicks) completedTicks = expectedTicks - 1;
+        SysTick->LOAD = (completedTicks + 1) * cyclesPerTick - completedCycles;
+    }
+
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = cyclesPerTick - 1;      // Se toma en la proxima recarga
+
+    stepTickCount(completedTicks);
+
+    osExitCriticalSection();
+}
+#endif
+
+// Función para bloquear una tarea durante un número de ticks
+
+void osDelay(const uint32_t tick)
+{
+    osEnterCriticalSection();
+
+    osTaskObject *task = getRunningTask();
+
+    if (task != NULL && tick > 0)
+    {
+        // Bloquea la tarea actual y la ubica en la lista de dormidas segun su tick de despertar
+        taskSetBlocked(task);
+        task->taskWakeTick = OsKernel.osTickCount + ((tick > OS_MAX_TIMEOUT) ? OS_MAX_TIMEOUT : tick);
+        delayListInsert(task);
 
         // Yieldea para permitir que otras tareas se ejecuten
         osYield();
@@ -413,123 +895,290 @@ void osDelay(const uint32_t tick)
 }
 
 //==========new Functions
-void blockTaskFromSem(osSemaphoreObject* semaphore)
+void checkBlockedTaskFromQueueN(osQueueObject *queue, uint8_t sender, uint32_t count)
 {
-    osTaskObject *task = NULL;
-    task = getRunningTask();
-    if (task != NULL)
+    osTaskListObject *list = sender ? &queue->waitReceive : &queue->waitSend;
+    osTaskObject *task, *best = NULL;
+
+    // Se despiertan todas juntas y se decide una sola vez si alguna desaloja a la actual
+    while (count-- > 0 && (task = list->head) != NULL)
     {
-    	task->semaphoreTask = semaphore;
-        task->semaphoreBlocked = true;
-        task->taskExecStatus = OS_TASK_BLOCK;
+        readyWaitingTask(list, task);
+        if (best == NULL || task->taskPriority < best->taskPriority) best = task;
     }
-    osYield();
+
+    if (best != NULL) preemptIfHigherPriority(best);
+}
+
+osResultType blockTaskFromSem(osSemaphoreObject* semaphore, uint32_t count, uint32_t timeout)
+{
+    osTaskObject *task = getRunningTask();
+
+    if (task != NULL) task->taskWaitValue = count;
+    return blockTaskOnList(&semaphore->waitList, timeout);
 }
 
 void checkBlockedTaskFromSem(osSemaphoreObject *semaphore)
 {
-    osTaskObject *task = NULL;
-    task = findBlockedTaskFromSemaphore(semaphore);
-    if (task != NULL)
+    wakeTaskFromList(&semaphore->waitList);
+}
+
+osResultType blockTaskFromQueue(osQueueObject *queue, uint8_t sender, uint32_t timeout)
+{
+    // El emisor espera lugar (cola llena), el receptor espera datos (cola vacia)
+    return blockTaskOnList(sender ? &queue->waitSend : &queue->waitReceive, timeout);
+}
+
+void checkBlockedTaskFromQueue(osQueueObject *queue, uint8_t sender)
+{
+    // Un envio despierta a un receptor y una recepcion a un emisor de esta misma cola
+    wakeTaskFromList(sender ? &queue->waitReceive : &queue->waitSend);
+}
+
+osResultType blockTaskFromMutex(osMutexObject* mutex, uint32_t timeout)
+{
+    osTaskObject *task = getRunningTask();
+    osMutexObject *next = mutex;
+
+    if (task == NULL || timeout == 0) return OS_WOULD_BLOCK;
+
+    task->taskWaitMutex = mutex;
+
+    // Presta su prioridad al dueño y, si este espera otro mutex, a los dueños siguientes. La cadena
+    // esta acotada por MAX_TASKS y se corta en el primer dueño que ya corre a esta prioridad o mas
+    for (uint32_t depth = 0; next != NULL && next->owner != NULL && depth < MAX_TASKS; depth++)
     {
-        task->taskExecStatus = OS_TASK_READY;
-        task->semaphoreBlocked = false;
-    	task->semaphoreTask = NULL;
+        if (next->owner->taskPriority <= task->taskPriority) break;
+        taskSetPriority(next->owner, task->taskPriority);
+        next = next->owner->taskWaitMutex;
     }
-    osYield();
+
+    return blockTaskOnList(&mutex->waitList, timeout);
 }
 
-void blockTaskFromQueue(osQueueObject *queue, uint8_t sender)
+void checkBlockedTaskFromMutex(osMutexObject *mutex)
 {
-    osTaskObject *task = NULL;
-    task = getRunningTask();
-    if (task != NULL)
+    osTaskObject *task = mutex->waitList.head;
+    osPriorityType priority;
+
+    if (task == NULL) return;
+
+    // Traspaso directo: la tarea despierta ya es la dueña, nadie puede ganarle el mutex
+    mutex->owner = task;
+    mutex->lockCount = 1;
+    mutex->ownerNext = task->taskMutexList;
+    task->taskMutexList = mutex;
+    task->taskWaitMutex = NULL;
+
+    wakeTaskFromList(&mutex->waitList);
+
+    // Hereda de las que siguen esperando (nunca mas prioritarias que ella) o sube al techo
+    priority = task->taskPriority;
+    updateTaskMutexPriority(task);
+    if (task->taskPriority != priority) preemptIfHigherPriority(task);
+}
+
+void updateTaskMutexPriority(osTaskObject* task)
+{
+    osPriorityType priority = task->taskBasePriority;
+    osMutexObject* mutex;
+
+    for (mutex = task->taskMutexList; mutex != NULL; mutex = mutex->ownerNext)
     {
-        if(sender)  task->taskBlockedByFullQueue = true;
-        else        task->taskBlockedByEmptyQueue = true;
-        if(sender)  task->queueFull  = queue;
-        else        task->queueEmpty = queue;
-        task->taskExecStatus = OS_TASK_BLOCK;
+        if (mutex->protocol == OS_MUTEX_CEILING && mutex->ceiling < priority) priority = mutex->ceiling;
+
+        // La lista de espera esta ordenada por prioridad: la cabeza es la mas prioritaria
+        if (mutex->waitList.head != NULL && mutex->waitList.head->taskPriority < priority)
+        {
+            priority = mutex->waitList.head->taskPriority;
+        }
     }
-    osYield();
+
+    taskSetPriority(task, priority);
 }
 
-void checkBlockedTaskFromQueue(osQueueObject *queue, uint8_t sender)
+osResultType blockTaskFromEventGroup(osEventGroupObject* group, uint32_t mask, uint32_t options, uint32_t* flags, uint32_t timeout)
 {
-    osTaskObject *task = NULL;
-    task = findBlockedTaskFromQueue(sender);
+    osTaskObject *task = getRunningTask();
+    osResultType result;
+
     if (task != NULL)
     {
-        task->taskExecStatus = OS_TASK_READY;
-        if (sender) task->taskBlockedByEmptyQueue = false;
-        else        task->taskBlockedByFullQueue  = false;
-        if (sender) task->queueFull = NULL;
-        else        task->queueEmpty= NULL;
+        task->taskWaitValue = mask;
+        task->taskWaitOptions = options;
     }
-    osYield();
+
+    result = blockTaskOnList(&group->waitList, timeout);
+
+    // Al despertarla, checkBlockedTaskFromEventGroup reemplaza la mascara por los bits que la cumplieron
+    *flags = (result == OS_OK) ? task->taskWaitValue : group->flags;
+    return result;
 }
 
-osTaskObject* findBlockedTaskFromQueue(uint8_t sender)
+void checkBlockedTaskFromEventGroup(osEventGroupObject* group)
 {
-    for (uint8_t i = 0; i < osTasksCreated; i++)
+    const uint32_t flags = group->flags;
+    uint32_t clear = 0;
+    osTaskObject *task = group->waitList.head;
+    osTaskObject *next;
+
+    // Todas las esperas se evaluan contra los mismos bits; los que se consumen se borran al final
+    while (task != NULL)
     {
-        if( OsKernel.osListTask[i]->taskExecStatus == OS_TASK_BLOCK)
+        next = task->taskNext;
+
+        if ((task->taskWaitOptions & OS_EVENT_WAIT_ALL) ? ((flags & task->taskWaitValue) == task->taskWaitValue)
+                                                        : ((flags & task->taskWaitValue) != 0))
         {
-            switch(sender)
-            {
-                case 0:
-                {
-                    if (OsKernel.osListTask[i]->taskBlockedByFullQueue == true)
-                    {
-                        return OsKernel.osListTask[i];
-                    }
-                }
-                break;
-
-                case 1:
-                {
-                    if (OsKernel.osListTask[i]->taskBlockedByEmptyQueue == true)
-                    {
-                        return OsKernel.osListTask[i];
-                    }
-                }
-                break;
-            }
+            if (task->taskWaitOptions & OS_EVENT_CLEAR_ON_EXIT) clear |= task->taskWaitValue;
+            task->taskWaitValue = flags;
+            wakeTask(&group->waitList, task);
         }
+        task = next;
     }
-    return NULL;
+
+    group->flags &= ~clear;
 }
 
-osTaskObject* findBlockedTaskFromSemaphore(osSemaphoreObject *semaphore)
+void osTaskNotify(osTaskObject* task, const uint32_t value, const osNotifyActionType action)
 {
-	osTaskObject *task = NULL;
-    for (uint8_t i = 0; i < osTasksCreated; i++)
+    osEnterCriticalSection();
+
+    switch (action)
     {
-        if( OsKernel.osListTask[i]->taskExecStatus == OS_TASK_BLOCK)
-        {
-            if (OsKernel.osListTask[i]->semaphoreBlocked == true && OsKernel.osListTask[i]->semaphoreTask == semaphore)
-            {
-            	task = OsKernel.osListTask[i];
-                return task;
-            }
-        }
+        case OS_NOTIFY_SET_BITS:    task->taskNotifyValue |= value; break;
+        case OS_NOTIFY_INCREMENT:   task->taskNotifyValue++;        break;
+        case OS_NOTIFY_OVERWRITE:   task->taskNotifyValue = value;  break;
+        default:                                                    break;
     }
-    return NULL;
+
+    // La tarea esperando no esta en ninguna lista de objeto: se la despierta directamente, sin busqueda
+    if (task->taskNotifyState == OS_NOTIFY_STATE_WAITING) wakeTask(NULL, task);
+    task->taskNotifyState = OS_NOTIFY_STATE_PENDING;
+
+    osExitCriticalSection();
+}
+
+osResultType osTaskNotifyWait(const uint32_t clearOnEntry, const uint32_t clearOnExit, uint32_t* value, const uint32_t timeout)
+{
+    return taskNotifyWait(clearOnEntry, clearOnExit, value, timeout, false);
 }
 
+osResultType osTaskNotifyWaitUntil(const uint32_t clearOnEntry, const uint32_t clearOnExit, uint32_t* value, const uint32_t wakeTick)
+{
+    return taskNotifyWait(clearOnEntry, clearOnExit, value, wakeTick, true);
+}
 
-osTaskObject* getRunningTask(void)
+static osResultType taskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, uint32_t ticks, bool absolute)
 {
-    osTaskObject *task = NULL;
-    for (uint8_t i = 0; i < osTasksCreated; i++)
+    osTaskObject *task;
+    osResultType result = OS_OK;
+
+    osEnterCriticalSection();
+
+    task = getRunningTask();
+    if (task == NULL)
     {
-        if(OsKernel.osListTask[i]->taskExecStatus == OS_TASK_RUNNING)
+        osExitCriticalSection();
+        return OS_ERROR;
+    }
+
+    if (task->taskNotifyState != OS_NOTIFY_STATE_PENDING)
+    {
+        task->taskNotifyValue &= ~clearOnEntry;
+
+        // El vencimiento absoluto se pasa a relativo con el tick detenido: no se corre aunque la llamada se atrase
+        if (absolute) ticks = ((int32_t)(ticks - OsKernel.osTickCount) > 0) ? ticks - OsKernel.osTickCount : 0;
+
+        if (absolute && ticks == 0)
         {
-            task = OsKernel.osListTask[i];
-            return task;
+            result = OS_TIMEOUT;
+        }
+        else
+        {
+            task->taskNotifyState = OS_NOTIFY_STATE_WAITING;
+            result = blockTaskOnList(NULL, ticks);
         }
     }
-    return task;
+
+    if (value != NULL) *value = task->taskNotifyValue;
+    if (result == OS_OK) task->taskNotifyValue &= ~clearOnExit;
+    task->taskNotifyState = OS_NOTIFY_STATE_NONE;
+
+    osExitCriticalSection();
+    return result;
+}
+
+osResultType blockTaskFromQueueSet(osQueueSetObject* set, uint32_t timeout)
+{
+    return blockTaskOnList(&set->waitList, timeout);
+}
+
+void checkBlockedTaskFromQueueSet(osQueueSetObject* set)
+{
+    wakeTaskFromList(&set->waitList);
+}
+
+osResultType blockTaskFromMessageBuffer(osMessageBufferObject* buffer, uint8_t sender, uint32_t needed, uint32_t timeout)
+{
+    osTaskObject *task = getRunningTask();
+
+    if (!sender) return blockTaskOnList(&buffer->waitReceive, timeout);
+
+    if (task != NULL) task->taskWaitValue = needed;
+    return blockTaskOnList(&buffer->waitSend, timeout);
+}
+
+void checkBlockedTaskFromMessageBuffer(osMessageBufferObject* buffer, uint8_t sender)
+{
+    uint32_t available;
+
+    if (sender)
+    {
+        wakeTaskFromList(&buffer->waitReceive);
+        return;
+    }
+
+    // Se reparte el lugar libre: no se despierta a un emisor que despues no entraria
+    available = buffer->size - buffer->used;
+    while (buffer->waitSend.head != NULL && buffer->waitSend.head->taskWaitValue <= available)
+    {
+        available -= buffer->waitSend.head->taskWaitValue;
+        wakeTaskFromList(&buffer->waitSend);
+    }
+}
+
+osResultType blockTaskFromPool(osPoolObject* pool, uint32_t timeout)
+{
+    return blockTaskOnList(&pool->waitList, timeout);
+}
+
+void checkBlockedTaskFromPool(osPoolObject* pool)
+{
+    wakeTaskFromList(&pool->waitList);
+}
+
+static osTaskObject* getRunningTask(void)
+{
+    // osCurrentTaskCallback es la unica referencia a la tarea en ejecucion: solo getNextContext la cambia.
+    // IPSR distinto de cero es cualquier handler, pase o no por osIRQHandler (SysTick, los de la HAL, etc.)
+    if (OsKernel.osStatus != OS_STATUS_RUNNING || __get_IPSR() != 0) return NULL;
+
+    return OsKernel.osCurrentTaskCallback;
+}
+
+osTaskObject* osGetRunningTask(void)
+{
+    return getRunningTask();
+}
+
+const osKernelStatsObject* osGetKernelStats(void)
+{
+#if OS_KERNEL_STATS
+    return &OsKernelStats;
+#else
+    return NULL;
+#endif
 }
 
 ///====
@@ -547,9 +1196,11 @@ void osCallSche(void){
 }*/
 void osYield(void)
 {
+    // Desde una ISR solo se marca el pedido; osIRQHandler replanifica al salir con el estado ya restaurado
     if (osGetStatus() == OS_STATUS_IRQ)
     {
         OsKernel.inISRContext = true;
+        return;
     }
 
     scheduler();
@@ -557,6 +1208,20 @@ void osYield(void)
     __ISB();
     __DSB();
 }
+uint32_t osGetTickCount(void)
+{
+    return OsKernel.osTickCount;
+}
+
+uint32_t osGetRemainingTicks(uint32_t startTick, uint32_t timeout)
+{
+    uint32_t elapsed = OsKernel.osTickCount - startTick;
+
+    if (timeout == OS_MAX_DELAY) return OS_MAX_DELAY;
+
+    return (elapsed >= timeout) ? 0 : timeout - elapsed;
+}
+
 OsStatus osGetStatus(void){
 	return OsKernel.osStatus;
 
@@ -613,6 +1278,10 @@ __attribute__((weak)) void osIdleTask(void)
 {
     while (1)
     {
+#if OS_USE_TICKLESS_IDLE
+        osTicklessIdle();
+#else
         __WFI();
+#endif
     }
 }
@@ -0,0 +1,176 @@
+/*
+ * osMessageBuffer.c
+ *
+ * Mensajes de largo variable, guardados con un prefijo de largo uno detras de otro en un anillo de bytes.
+ */
+#include <string.h>
+
+#include <osMessageBuffer.h>
+#include "osKernel.h"
+
+/**
+ * @brief Copia bytes al anillo a partir de index, partiendo la copia si da la vuelta.
+ * @return Indice siguiente al ultimo byte escrito.
+ */
+static uint32_t messageCopyIn(osMessageBufferObject* buffer, uint32_t index, const void* source, uint32_t length);
+/**
+ * @brief Copia bytes del anillo a partir de index, partiendo la copia si da la vuelta.
+ * @return Indice siguiente al ultimo byte leido.
+ */
+static uint32_t messageCopyOut(osMessageBufferObject* buffer, uint32_t index, void* destination, uint32_t length);
+/**
+ * @brief Lee el prefijo de largo del proximo mensaje. Requiere al menos un mensaje.
+ */
+static uint32_t messagePeekLength(osMessageBufferObject* buffer);
+/**
+ * @brief Indica si un emisor que todavia no espero debe hacer fila detras de los emisores bloqueados.
+ */
+static bool messageMustQueue(osMessageBufferObject* buffer);
+
+bool osMessageBufferInit(osMessageBufferObject* buffer, void* storage, const uint32_t size){
+    if (buffer == NULL || storage == NULL || size <= OS_MESSAGE_HEADER_SIZE) return false;
+
+    buffer->data = storage;
+    buffer->size = size;
+    buffer->head = 0;
+    buffer->tail = 0;
+    buffer->used = 0;
+    osTaskListInit(&buffer->waitSend, OS_WAIT_FIFO);
+    osTaskListInit(&buffer->waitReceive, OS_WAIT_FIFO);
+    return true;
+}
+
+osResultType osMessageBufferSend(osMessageBufferObject* buffer, const void* message, const uint32_t length, const uint32_t timeout){
+    const uint32_t startTick = osGetTickCount();
+    const uint32_t needed = length + OS_MESSAGE_HEADER_SIZE;
+    osResultType result;
+    bool waited = false;
+    uint16_t header = (uint16_t)length;
+
+    if (length == 0 || length > OS_MESSAGE_MAX_LENGTH || needed > buffer->size) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    // El mensaje entra entero o no entra: se espera lugar para el prefijo y todo el contenido.
+    // Un emisor nuevo no usa el lugar que se les esta repartiendo a los que ya esperan
+    while (buffer->size - buffer->used < needed || (!waited && messageMustQueue(buffer)))
+    {
+        uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+
+        if (waited && remaining == 0) result = OS_TIMEOUT;
+        else                          result = blockTaskFromMessageBuffer(buffer, 1, needed, remaining);
+        waited = true;
+
+        if (result != OS_OK)
+        {
+            // El lugar que se le habia reservado, o el que frenaba a los de atras, pasa a los siguientes
+            if (result == OS_TIMEOUT) checkBlockedTaskFromMessageBuffer(buffer, 0);
+            osExitCriticalSection();
+            return result;
+        }
+    }
+
+    buffer->head = messageCopyIn(buffer, buffer->head, &header, OS_MESSAGE_HEADER_SIZE);
+    buffer->head = messageCopyIn(buffer, buffer->head, message, length);
+    buffer->used += needed;
+
+    checkBlockedTaskFromMessageBuffer(buffer, 1); // Despierta a un receptor
+
+    osExitCriticalSection();
+    return OS_OK;
+}
+
+osResultType osMessageBufferReceive(osMessageBufferObject* buffer, void* message, const uint32_t capacity, uint32_t* length, const uint32_t timeout){
+    const uint32_t startTick = osGetTickCount();
+    osResultType result;
+    bool waited = false;
+    uint32_t messageLength;
+
+    osEnterCriticalSection();
+
+    while (buffer->used == 0)
+    {
+        uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+
+        if (waited && remaining == 0) result = OS_TIMEOUT;
+        else                          result = blockTaskFromMessageBuffer(buffer, 0, 0, remaining);
+        waited = true;
+
+        if (result != OS_OK)
+        {
+            // Pudo vencer justo despues de que un envio lo despertara: el aviso pasa al siguiente receptor
+            if (result == OS_TIMEOUT && buffer->used != 0) checkBlockedTaskFromMessageBuffer(buffer, 1);
+            osExitCriticalSection();
+            return result;
+        }
+    }
+
+    messageLength = messagePeekLength(buffer);
+    *length = messageLength;
+
+    // Si no entra en el buffer del llamador el mensaje queda: se puede volver a pedir con mas lugar
+    if (messageLength > capacity)
+    {
+        checkBlockedTaskFromMessageBuffer(buffer, 1); // Otro receptor puede tener lugar para el mensaje
+        osExitCriticalSection();
+        return OS_ERROR;
+    }
+
+    buffer->tail = messageCopyOut(buffer, buffer->tail + OS_MESSAGE_HEADER_SIZE, message, messageLength);
+    buffer->used -= messageLength + OS_MESSAGE_HEADER_SIZE;
+
+    // Despierta, en orden, a los emisores cuyos mensajes entran en el lugar liberado
+    checkBlockedTaskFromMessageBuffer(buffer, 0);
+
+    osExitCriticalSection();
+    return OS_OK;
+}
+
+uint32_t osMessageBufferPeekLength(osMessageBufferObject* buffer){
+    uint32_t length = 0;
+
+    osEnterCriticalSection();
+    if (buffer->used != 0) length = messagePeekLength(buffer);
+    osExitCriticalSection();
+
+    return length;
+}
+
+static uint32_t messageCopyIn(osMessageBufferObject* buffer, uint32_t index, const void* source, uint32_t length){
+    const uint32_t first = (length < buffer->size - index) ? length : buffer->size - index;
+
+    memcpy(&buffer->data[index], source, first);
+    memcpy(buffer->data, (const uint8_t*)source + first, length - first);
+
+    return (index + length) % buffer->size;
+}
+
+static uint32_t messageCopyOut(osMessageBufferObject* buffer, uint32_t index, void* destination, uint32_t length){
+    uint32_t first;
+
+    index %= buffer->size;
+    first = (length < buffer->size - index) ? length : buffer->size - index;
+
+    memcpy(destination, &buffer->data[index], first);
+    memcpy((uint8_t*)destination + first, buffer->data, length - first);
+
+    return (index + length) % buffer->size;
+}
+
+static uint32_t messagePeekLength(osMessageBufferObject* buffer){
+    uint16_t header;
+
+    messageCopyOut(buffer, buffer->tail, &header, OS_MESSAGE_HEADER_SIZE);
+    return header;
+}
+
+static bool messageMustQueue(osMessageBufferObject* buffer){
+    osTaskObject* head = buffer->waitSend.head;
+    osTaskObject* task;
+
+    if (head == NULL) return false;
+
+    // Por prioridad la tarea actual quedaria delante de las de menor prioridad: no se adelanta a nadie
+    task = osGetRunningTask();
+    return !(buffer->waitSend.order == OS_WAIT_PRIORITY && task != NULL && task->taskPriority < head->taskPriority);
+}
@@ -0,0 +1,94 @@
+/*
+ * osMutex.c
+ *
+ * Mutex con dueño, bloqueo recursivo y herencia de prioridad (o techo de prioridad inmediato).
+ */
+#include <osMutex.h>
+#include "osKernel.h"
+
+// Inicializa un mutex libre
+void osMutexInit(osMutexObject* mutex, osMutexProtocolType protocol, osPriorityType ceiling){
+    mutex->owner = NULL;
+    mutex->lockCount = 0;
+    mutex->protocol = protocol;
+    mutex->ceiling = ceiling;
+    osTaskListInit(&mutex->waitList, OS_WAIT_PRIORITY); // La herencia le presta al dueño la prioridad de la cabeza
+    mutex->ownerNext = NULL;
+}
+
+// Toma el mutex
+osResultType osMutexLock(osMutexObject* mutex, const uint32_t timeout){
+    osTaskObject* task;
+    osResultType result = OS_OK;
+
+    // Un mutex tiene dueño: solo lo puede tomar una tarea en ejecucion, nunca un handler
+    task = osGetRunningTask();
+    if (task == NULL) return OS_ERROR;
+
+    if (mutex->protocol == OS_MUTEX_CEILING && task->taskBasePriority < mutex->ceiling) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    if (mutex->owner == NULL)
+    {
+        mutex->owner = task;
+        mutex->lockCount = 1;
+        mutex->ownerNext = task->taskMutexList;
+        task->taskMutexList = mutex;
+
+        // Con techo sube ya a la prioridad techo: ninguna otra usuaria puede desalojarla mientras lo posea
+        if (mutex->protocol == OS_MUTEX_CEILING) updateTaskMutexPriority(task);
+    }
+    else if (mutex->owner == task)
+    {
+        mutex->lockCount++;
+    }
+    else
+    {
+        // Bloquea la tarea actual; si la despierta un unlock, este ya la dejo como dueña
+        result = blockTaskFromMutex(mutex, timeout);
+    }
+
+    osExitCriticalSection();
+    return result;
+}
+
+// Devuelve el mutex
+osResultType osMutexUnlock(osMutexObject* mutex){
+    osTaskObject* task = osGetRunningTask();
+    osMutexObject** link;
+    osPriorityType priority;
+
+    if (task == NULL) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    if (mutex->owner != task)
+    {
+        osExitCriticalSection();
+        return OS_ERROR;
+    }
+
+    if (--mutex->lockCount > 0)
+    {
+        osExitCriticalSection();
+        return OS_OK;
+    }
+
+    // Sale de la lista de mutex del dueño; si se liberan en orden inverso es siempre la cabeza
+    for (link = &task->taskMutexList; *link != mutex; link = &(*link)->ownerNext);
+    *link = mutex->ownerNext;
+    mutex->ownerNext = NULL;
+    mutex->owner = NULL;
+
+    // Primero devuelve la prioridad prestada, asi la tarea que recibe el mutex la desaloja si corresponde
+    priority = task->taskPriority;
+    updateTaskMutexPriority(task);
+    checkBlockedTaskFromMutex(mutex);
+
+    // Bajo de prioridad: puede haber otra tarea lista mas prioritaria que la que recibio el mutex
+    if (task->taskPriority != priority) osYield();
+
+    osExitCriticalSection();
+    return OS_OK;
+}
@@ -0,0 +1,153 @@
+/*
+ * osPool.c
+ *
+ * Pool de bloques de tamaño fijo: la lista de libres vive dentro de los mismos bloques, asi pedir y
+ * devolver son O(1) y no hace falta memoria extra.
+ */
+#include <osPool.h>
+#include "osKernel.h"
+
+// Marca en la segunda palabra de un bloque libre (todo bloque tiene al menos 8 bytes). Depende de la
+// direccion para que un dato del usuario que quede en un bloque no la repita por casualidad
+#define POOL_FREE_MARK(block)   ((uint32_t)(block) ^ 0x5AA5C33CU)
+
+/**
+ * @brief Indica si un bloque del pool ya esta en la lista de libres.
+ *
+ * Si el bloque no tiene la marca de libre la respuesta es inmediata; si la tiene se confirma recorriendo
+ * la lista, porque el usuario pudo haber dejado justo ese valor en el bloque.
+ */
+static bool poolIsFree(osPoolObject* pool, void* block);
+
+bool osPoolInit(osPoolObject* pool, void* buffer, const uint32_t blockSize, const uint32_t count){
+    const uint32_t stride = OS_POOL_BLOCK_STRIDE(blockSize);
+    uint8_t *blocks = buffer;
+
+    if (pool == NULL || buffer == NULL || blockSize == 0 || count == 0 || ((uint32_t)buffer & 0x7U) != 0) return false;
+
+    pool->blocks = blocks;
+    pool->blockSize = blockSize;
+    pool->blockStride = stride;
+    pool->count = count;
+    pool->freeCount = count;
+    pool->minFree = count;
+    pool->failCount = 0;
+    osTaskListInit(&pool->waitList, OS_WAIT_FIFO);
+
+    // Todos los bloques arrancan libres, enlazados por su primera palabra
+    for (uint32_t i = 0; i < count; i++)
+    {
+        *(void**)&blocks[i * stride] = (i + 1 < count) ? &blocks[(i + 1) * stride] : NULL;
+        ((uint32_t*)&blocks[i * stride])[1] = POOL_FREE_MARK(&blocks[i * stride]);
+    }
+    pool->freeList = blocks;
+
+    return true;
+}
+
+osResultType osPoolAlloc(osPoolObject* pool, void** block, const uint32_t timeout){
+    const uint32_t startTick = osGetTickCount();
+    osResultType result;
+    bool waited = false;
+
+    *block = NULL;
+
+    osEnterCriticalSection();
+
+    // Otra tarea o una ISR puede llevarse el bloque liberado antes, por eso se vuelve a verificar
+    while (pool->freeList == NULL)
+    {
+        uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+
+        if (waited && remaining == 0) result = OS_TIMEOUT;
+        else                          result = blockTaskFromPool(pool, remaining);
+        waited = true;
+
+        if (result != OS_OK)
+        {
+            pool->failCount++;
+            osExitCriticalSection();
+            return result;
+        }
+    }
+
+    *block = pool->freeList;
+    pool->freeList = *(void**)pool->freeList;
+    ((uint32_t*)*block)[1] = 0;
+    pool->freeCount--;
+    if (pool->freeCount < pool->minFree) pool->minFree = pool->freeCount;
+
+    osExitCriticalSection();
+    return OS_OK;
+}
+
+osResultType osPoolFree(osPoolObject* pool, void* block){
+    if (!osPoolOwnsBlock(pool, block)) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    // Doble liberacion: volver a enlazarlo armaria un ciclo en la lista y freeCount pasaria de count
+    if (pool->freeCount >= pool->count || poolIsFree(pool, block))
+    {
+        osExitCriticalSection();
+        return OS_ERROR;
+    }
+
+    *(void**)block = pool->freeList;
+    ((uint32_t*)block)[1] = POOL_FREE_MARK(block);
+    pool->freeList = block;
+    pool->freeCount++;
+
+    checkBlockedTaskFromPool(pool); // Despierta a una tarea esperando bloque
+
+    osExitCriticalSection();
+    return OS_OK;
+}
+
+void osPoolGetStats(osPoolObject* pool, osPoolStatsObject* stats){
+    osEnterCriticalSection();
+
+    stats->blockSize = pool->blockSize;
+    stats->blockStride = pool->blockStride;
+    stats->count = pool->count;
+    stats->used = pool->count - pool->freeCount;
+    stats->peakUsed = pool->count - pool->minFree;
+    stats->failCount = pool->failCount;
+
+    osExitCriticalSection();
+}
+
+void osPoolSetWaitOrder(osPoolObject* pool, osWaitOrderType order){
+    pool->waitList.order = order;
+}
+
+bool osPoolOwnsBlock(osPoolObject* pool, void* block){
+    uint32_t offset = (uint8_t*)block - pool->blocks;
+
+    // Tiene que caer dentro del pool y justo al comienzo de un bloque (no se aceptan punteros al interior)
+    return offset < pool->count * pool->blockStride && (offset % pool->blockStride) == 0;
+}
+
+bool osPoolIsAllocated(osPoolObject* pool, void* block){
+    bool allocated;
+
+    if (!osPoolOwnsBlock(pool, block)) return false;
+
+    osEnterCriticalSection();
+    allocated = !poolIsFree(pool, block);
+    osExitCriticalSection();
+
+    return allocated;
+}
+
+static bool poolIsFree(osPoolObject* pool, void* block){
+    void* next;
+
+    if (((uint32_t*)block)[1] != POOL_FREE_MARK(block)) return false;
+
+    for (next = pool->freeList; next != NULL; next = *(void**)next)
+    {
+        if (next == block) return true;
+    }
+    return false;
+}
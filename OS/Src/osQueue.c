@@ -4,97 +4,349 @@
  *  Created on: Oct 3, 2023
  *      Author: cesarcruz
  */
-#include <stdlib.h>
 #include <string.h>
 
 #include "osQueue.h"
 #include "osKernel.h"
 
-bool osQueueInit(osQueueObject* queue, const uint32_t dataSize)
+/**
+ * @brief Bloquea la tarea en la cola con lo que le queda del timeout.
+ * @param waited Indica si ya espero una vez; se actualiza.
+ * @return OS_OK si la despertaron, OS_TIMEOUT si ya no queda tiempo, OS_WOULD_BLOCK si no se puede esperar.
+ */
+static osResultType queueWait(osQueueObject* queue, uint8_t sender, uint32_t startTick, uint32_t timeout, bool* waited);
+/**
+ * @brief Copia un elemento al final del anillo. Requiere lugar libre.
+ */
+static void queuePut(osQueueObject* queue, const void* data);
+/**
+ * @brief Copia el primer elemento del anillo y lo quita. Requiere al menos un elemento.
+ */
+static void queueGet(osQueueObject* queue, void* buffer);
+
+bool osQueueInit(osQueueObject* queue, void* buffer, const uint32_t capacity, const uint32_t dataSize)
 {
-	    if (queue != NULL) {
+	    if (queue != NULL && buffer != NULL && capacity > 0 && dataSize > 0) {
+	        queue->data = buffer;
+	        queue->capacity = capacity;
 	        queue->dataSize = dataSize;
 	        queue->currentSize = 0;
-	        queue->endIndex = -1;
+	        queue->endIndex = 0;
 	        queue->startIndex = 0;
+	        queue->pool = NULL;
+	        osTaskListInit(&queue->waitSend, OS_WAIT_FIFO);
+	        osTaskListInit(&queue->waitReceive, OS_WAIT_FIFO);
+	        queue->set = NULL;
 	        return true;
 	    }
 	    return false;
 
 }
-bool osQueueSend(osQueueObject* queue, const void* data, const uint32_t timeout)
+
+bool osQueueInitZeroCopy(osQueueObject* queue, void* buffer, const uint32_t capacity, const uint32_t blockSize)
 {
+    uint8_t *ring = (uint8_t*)buffer + OS_POOL_BUFFER_SIZE(capacity, blockSize);
+    osPoolObject *pool = (osPoolObject*)(ring + capacity * sizeof(void*));
+
+    // NULL pasaria el control de alineacion y la lista de libres se armaria desde la direccion 0
+    if (queue == NULL || buffer == NULL || capacity == 0 || blockSize == 0 || ((uint32_t)buffer & 0x7U) != 0) return false;
+
+    // Los bloques son un pool; el anillo de punteros y el objeto del pool van detras
+    if (!osPoolInit(pool, buffer, blockSize, capacity)) return false;
+    if (!osQueueInit(queue, ring, capacity, sizeof(void*))) return false;
+
+    queue->pool = pool;
+    return true;
+}
+
+void osQueueSetWaitOrder(osQueueObject* queue, osWaitOrderType order)
+{
+    queue->waitSend.order = order;
+    queue->waitReceive.order = order;
+    if (queue->pool != NULL) osPoolSetWaitOrder(queue->pool, order);
+}
+
+osResultType osQueueSend(osQueueObject* queue, const void* data, const uint32_t timeout)
+{
+    const uint32_t startTick = osGetTickCount();
+    osResultType result;
+    bool waited = false;
+
+    // En una cola sin copia solo viajan bloques propios, via osQueueCommitBlock
+    if (queue->pool != NULL) return OS_ERROR;
+
     osEnterCriticalSection();
 
-    // Verificar si la cola está llena
-    if (queue->currentSize >= MAX_SIZE_QUEUE)
+    // Mientras la cola esté llena espera lugar; otro emisor puede ganarlo antes, por eso se vuelve a verificar
+    while (queue->currentSize >= queue->capacity)
     {
-        blockTaskFromQueue(queue, 1);
-        osExitCriticalSection();
-        return false;  // Cola llena, no se puede enviar
+        result = queueWait(queue, 1, startTick, timeout, &waited);
+        if (result != OS_OK)
+        {
+            osExitCriticalSection();
+            return result;  // Cola llena, no se puede enviar
+        }
     }
 
-    // Calcular el índice del próximo elemento
-    queue->endIndex = (queue->endIndex + 1) % MAX_SIZE_QUEUE;
+    queuePut(queue, data);
+
+    checkBlockedTaskFromQueue(queue, 1); // Despierta a un receptor, si hay alguno esperando
+    if (queue->set != NULL) checkBlockedTaskFromQueueSet(queue->set);
+
+    osExitCriticalSection();
+    return OS_OK;  // Envío exitoso
+}
+
 
-    // Intentar asignar memoria
-    queue->data[queue->endIndex] = malloc(queue->dataSize);
+osResultType osQueueReceive(osQueueObject* queue, void* buffer, const uint32_t timeout)
+{
+    const uint32_t startTick = osGetTickCount();
+    osResultType result;
+    bool waited = false;
+
+    if (queue->pool != NULL) return OS_ERROR;
+
+	osEnterCriticalSection();
 
-    // Verificar si la asignación de memoria fue exitosa
-    if (queue->data[queue->endIndex] == NULL)
+    // Mientras la cola esté vacía espera datos; otro receptor puede tomarlos antes, por eso se vuelve a verificar
+    while (queue->currentSize == 0)
     {
-        // Liberar memoria asignada previamente, si la hubiera
-        for (uint32_t i = 0; i < queue->currentSize; i++)
+        result = queueWait(queue, 0, startTick, timeout, &waited);
+        if (result != OS_OK)
         {
-            free(queue->data[i]);
+            osExitCriticalSection();
+            return result;
         }
-
-        osExitCriticalSection();
-        return false;  // Error en la asignación de memoria
     }
 
-    // Copiar los datos al nuevo elemento
-    memcpy(queue->data[queue->endIndex], data, queue->dataSize);
+    queueGet(queue, buffer);
 
-    // Incrementar el tamaño actual de la cola
-    queue->currentSize++;
+    checkBlockedTaskFromQueue(queue, 0); // Despierta a un emisor, si hay alguno esperando
 
-    if (queue->currentSize == 1)
+	osExitCriticalSection();
+    return OS_OK;
+
+}
+
+osResultType osQueueOverwrite(osQueueObject* queue, const void* data)
+{
+    if (queue->pool != NULL) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    // Llena: se pisa el elemento mas viejo, asi el receptor siempre ve los ultimos capacity valores
+    if (queue->currentSize >= queue->capacity)
     {
-        checkBlockedTaskFromQueue(queue, 1); // Comprobar solo en el límite
+        queue->startIndex = (queue->startIndex + 1 == queue->capacity) ? 0 : queue->startIndex + 1;
+        queue->currentSize--;
     }
 
+    queuePut(queue, data);
+
+    checkBlockedTaskFromQueue(queue, 1);
+    if (queue->set != NULL) checkBlockedTaskFromQueueSet(queue->set);
+
     osExitCriticalSection();
-    return true;  // Envío exitoso
+    return OS_OK;
 }
 
+osResultType osQueuePeek(osQueueObject* queue, void* buffer, const uint32_t timeout)
+{
+    const uint32_t startTick = osGetTickCount();
+    osResultType result;
+    bool waited = false;
+
+    if (queue->pool != NULL) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    while (queue->currentSize == 0)
+    {
+        result = queueWait(queue, 0, startTick, timeout, &waited);
+        if (result != OS_OK)
+        {
+            osExitCriticalSection();
+            return result;
+        }
+    }
+
+    memcpy(buffer, &queue->data[queue->startIndex * queue->dataSize], queue->dataSize);
+
+    // El envio desperto a esta tarea en lugar de a un receptor; el dato sigue ahi, asi que se pasa el aviso
+    checkBlockedTaskFromQueue(queue, 1);
+
+    osExitCriticalSection();
+    return OS_OK;
+}
 
-bool osQueueReceive(osQueueObject* queue, void* buffer, const uint32_t timeout)
+osResultType osQueueSendBatch(osQueueObject* queue, const void* items, const uint32_t count, uint32_t* sent, const uint32_t timeout)
 {
-	osEnterCriticalSection();
-	if (queue->currentSize > 0)
+    const uint32_t startTick = osGetTickCount();
+    const uint8_t *item = items;
+    osResultType result;
+    bool waited = false;
+    uint32_t n = 0;
+
+    *sent = 0;
+    if (queue->pool != NULL || count == 0) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    while (queue->currentSize >= queue->capacity)
+    {
+        result = queueWait(queue, 1, startTick, timeout, &waited);
+        if (result != OS_OK)
+        {
+            osExitCriticalSection();
+            return result;
+        }
+    }
+
+    // Todo el lote en la misma seccion critica
+    while (n < count && queue->currentSize < queue->capacity)
     {
-		memcpy(buffer, queue->data[queue->startIndex], queue->dataSize);
-		free(queue->data[queue->startIndex]);
+        queuePut(queue, item);
+        item += queue->dataSize;
+        n++;
+    }
 
-        queue->startIndex = (queue->startIndex + 1)%MAX_SIZE_QUEUE;
-        queue->currentSize--;
+    // A lo sumo un receptor por elemento, y un solo osYield para todos
+    checkBlockedTaskFromQueueN(queue, 1, n);
+    if (queue->set != NULL) checkBlockedTaskFromQueueSet(queue->set);
+
+    osExitCriticalSection();
+
+    *sent = n;
+    return OS_OK;
+}
 
-        if (queue->currentSize == MAX_SIZE_QUEUE - 1) checkBlockedTaskFromQueue(queue, 0);
+osResultType osQueueReceiveBatch(osQueueObject* queue, void* buffer, const uint32_t count, uint32_t* received, const uint32_t timeout)
+{
+    const uint32_t startTick = osGetTickCount();
+    uint8_t *item = buffer;
+    osResultType result;
+    bool waited = false;
+    uint32_t n = 0;
+
+    *received = 0;
+    if (queue->pool != NULL || count == 0) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    while (queue->currentSize == 0)
+    {
+        result = queueWait(queue, 0, startTick, timeout, &waited);
+        if (result != OS_OK)
+        {
+            osExitCriticalSection();
+            return result;
+        }
     }
-    else
+
+    while (n < count && queue->currentSize > 0)
+    {
+        queueGet(queue, item);
+        item += queue->dataSize;
+        n++;
+    }
+
+    checkBlockedTaskFromQueueN(queue, 0, n);
+
+    osExitCriticalSection();
+
+    *received = n;
+    return OS_OK;
+}
+
+osResultType osQueueAllocBlock(osQueueObject* queue, void** block, const uint32_t timeout)
+{
+    if (queue->pool == NULL) return OS_ERROR;
+
+    // Sin bloques libres el productor espera en el pool, como en una cola llena
+    return osPoolAlloc(queue->pool, block, timeout);
+}
+
+osResultType osQueueCommitBlock(osQueueObject* queue, void* block)
+{
+    if (queue->pool == NULL || !osPoolIsAllocated(queue->pool, block)) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    // El anillo tiene un lugar por bloque, asi que solo se llena si se publica dos veces el mismo bloque
+    if (queue->currentSize >= queue->capacity)
     {
-        blockTaskFromQueue(queue,0);
         osExitCriticalSection();
-        return false;
+        return OS_ERROR;
     }
 
-	osExitCriticalSection();
-    return true;
+    queuePut(queue, &block);
+    checkBlockedTaskFromQueue(queue, 1);
+    if (queue->set != NULL) checkBlockedTaskFromQueueSet(queue->set);
+
+    osExitCriticalSection();
+    return OS_OK;
+}
+
+osResultType osQueueReceiveBlock(osQueueObject* queue, void** block, const uint32_t timeout)
+{
+    const uint32_t startTick = osGetTickCount();
+    osResultType result;
+    bool waited = false;
+
+    if (queue->pool == NULL) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    while (queue->currentSize == 0)
+    {
+        result = queueWait(queue, 0, startTick, timeout, &waited);
+        if (result != OS_OK)
+        {
+            osExitCriticalSection();
+            return result;
+        }
+    }
 
+    // Solo sale el puntero; el lugar del anillo se libera pero el bloque sigue ocupado hasta el release
+    queueGet(queue, block);
+
+    osExitCriticalSection();
+    return OS_OK;
+}
+
+osResultType osQueueReleaseBlock(osQueueObject* queue, void* block)
+{
+    if (queue->pool == NULL) return OS_ERROR;
+
+    // El pool valida el bloque, rechaza la doble liberacion y despierta a un productor esperando bloque
+    return osPoolFree(queue->pool, block);
 }
 
+static osResultType queueWait(osQueueObject* queue, uint8_t sender, uint32_t startTick, uint32_t timeout, bool* waited)
+{
+    uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+
+    // Si ya esperó una vez y no queda tiempo, vence; si no, OS_WOULD_BLOCK indica que no se podía esperar
+    if (*waited && remaining == 0) return OS_TIMEOUT;
 
+    *waited = true;
+    return blockTaskFromQueue(queue, sender, remaining);
+}
+
+static void queuePut(osQueueObject* queue, const void* data)
+{
+    // Copiar los datos en el lugar libre del buffer y avanzar el índice
+    memcpy(&queue->data[queue->endIndex * queue->dataSize], data, queue->dataSize);
+    queue->endIndex = (queue->endIndex + 1 == queue->capacity) ? 0 : queue->endIndex + 1;
 
+    // Incrementar el tamaño actual de la cola
+    queue->currentSize++;
+}
 
+static void queueGet(osQueueObject* queue, void* buffer)
+{
+    memcpy(buffer, &queue->data[queue->startIndex * queue->dataSize], queue->dataSize);
 
+    queue->startIndex = (queue->startIndex + 1 == queue->capacity) ? 0 : queue->startIndex + 1;
+    queue->currentSize--;
+}
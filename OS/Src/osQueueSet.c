@@ -0,0 +1,93 @@
+/*
+ * osQueueSet.c
+ *
+ * Conjuntos de colas y semaforos: una tarea espera en varios objetos a la vez.
+ */
+#include <osQueueSet.h>
+#include "osKernel.h"
+
+/**
+ * @brief Busca un miembro listo empezando por nextMember. Se llama dentro de una seccion critica.
+ * @return El objeto listo, o NULL si no hay ninguno.
+ */
+static void* queueSetFindReady(osQueueSetObject* set);
+
+void osQueueSetInit(osQueueSetObject* set){
+    set->memberCount = 0;
+    set->nextMember = 0;
+    osTaskListInit(&set->waitList, OS_WAIT_PRIORITY);
+}
+
+bool osQueueSetAddQueue(osQueueSetObject* set, osQueueObject* queue){
+    if (set->memberCount >= OS_QUEUE_SET_MAX_MEMBERS || queue->set != NULL) return false;
+
+    osEnterCriticalSection();
+    set->members[set->memberCount].object = queue;
+    set->members[set->memberCount].type = OS_SET_MEMBER_QUEUE;
+    set->memberCount++;
+    queue->set = set;
+    osExitCriticalSection();
+
+    return true;
+}
+
+bool osQueueSetAddSemaphore(osQueueSetObject* set, osSemaphoreObject* semaphore){
+    if (set->memberCount >= OS_QUEUE_SET_MAX_MEMBERS || semaphore->set != NULL) return false;
+
+    osEnterCriticalSection();
+    set->members[set->memberCount].object = semaphore;
+    set->members[set->memberCount].type = OS_SET_MEMBER_SEMAPHORE;
+    set->memberCount++;
+    semaphore->set = set;
+    osExitCriticalSection();
+
+    return true;
+}
+
+osResultType osSelect(osQueueSetObject* set, void** member, const uint32_t timeout){
+    const uint32_t startTick = osGetTickCount();
+    osResultType result = OS_OK;
+    bool waited = false;
+    void* ready;
+
+    if (set->memberCount == 0) return OS_ERROR;
+
+    osEnterCriticalSection();
+
+    // Otro lector del mismo miembro puede ganarle lo que la desperto: se vuelve a buscar
+    while ((ready = queueSetFindReady(set)) == NULL)
+    {
+        uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+
+        if (waited && remaining == 0) result = OS_TIMEOUT;
+        else                          result = blockTaskFromQueueSet(set, remaining);
+        waited = true;
+
+        if (result != OS_OK) break;
+    }
+
+    osExitCriticalSection();
+
+    *member = ready;
+    return result;
+}
+
+static void* queueSetFindReady(osQueueSetObject* set){
+    uint32_t index = set->nextMember;
+    osQueueSetMember* candidate;
+
+    for (uint32_t i = 0; i < set->memberCount; i++)
+    {
+        candidate = &set->members[index];
+        index = (index + 1 == set->memberCount) ? 0 : index + 1;
+
+        if ((candidate->type == OS_SET_MEMBER_QUEUE && ((osQueueObject*)candidate->object)->currentSize > 0) ||
+            (candidate->type == OS_SET_MEMBER_SEMAPHORE && ((osSemaphoreObject*)candidate->object)->count > 0))
+        {
+            // La proxima busqueda empieza en el siguiente: un miembro con mucho trafico no tapa a los demas
+            set->nextMember = index;
+            return candidate->object;
+        }
+    }
+    return NULL;
+}
@@ -7,40 +7,134 @@
 #include <osSemaphore.h>
 #include "osKernel.h"
 
+/**
+ * @brief Indica si la tarea actual puede llevarse count unidades sin adelantarse a las que ya esperan.
+ */
+static bool semaphoreCanTake(osSemaphoreObject* semaphore, const uint32_t count);
+/**
+ * @brief Entrega unidades en orden a las tareas cuyo pedido ya se puede cubrir y avisa al conjunto si sobra.
+ */
+static void semaphoreHandOut(osSemaphoreObject* semaphore);
+
 // Inicializa un objeto de semáforo
 void osSemaphoreInit(osSemaphoreObject* semaphore, const uint32_t maxCount, const uint32_t count){
     semaphore->maxCount = maxCount; // Establece el valor máximo permitido
-    semaphore->count = count;       // Establece el contador inicial
-    semaphore->lockedFlag = false;  // Inicialmente no bloqueado
+    semaphore->count = (count > maxCount) ? maxCount : count; // Establece el contador inicial
+    osTaskListInit(&semaphore->waitList, OS_WAIT_FIFO);
+    semaphore->set = NULL;
+}
+
+void osSemaphoreSetWaitOrder(osSemaphoreObject* semaphore, osWaitOrderType order){
+    semaphore->waitList.order = order;
 }
 
 // Intenta tomar el semáforo
-bool osSemaphoreTake(osSemaphoreObject* semaphore){
+osResultType osSemaphoreTake(osSemaphoreObject* semaphore, const uint32_t timeout){
+    return osSemaphoreTakeN(semaphore, 1, timeout);
+}
+
+osResultType osSemaphoreTakeN(osSemaphoreObject* semaphore, const uint32_t count, const uint32_t timeout){
+    uint32_t available;
+    osResultType result = OS_OK;
+
+    if (count == 0 || count > semaphore->maxCount) return OS_ERROR;
+
+    // Camino rapido: descuenta con LDREX/STREX sin deshabilitar interrupciones, solo si nadie espera
+    while (1)
+    {
+        available = __LDREXW(&semaphore->count);
+        if (available < count || semaphore->waitList.head != NULL)
+        {
+            __CLREX();
+            break;
+        }
+        if (__STREXW(available - count, &semaphore->count) == 0) return OS_OK;
+    }
 
     osEnterCriticalSection(); // Entra en la sección crítica
 
-    if (semaphore->lockedFlag == true)
+    if (semaphoreCanTake(semaphore, count))
     {
-        blockTaskFromSem(semaphore); // Bloquea la tarea actual si el semáforo ya está tomado
-        osExitCriticalSection();    // Sale de la sección crítica
-        return false;               // Devuelve false indicando que el semáforo no se tomó
+        semaphore->count -= count;
     }
     else
     {
-        semaphore->lockedFlag = true; // Marca el semáforo como tomado
+        // Bloquea la tarea actual; si la despierta un give, este ya le descontó las unidades pedidas
+        result = blockTaskFromSem(semaphore, count, timeout);
+
+        // Al vencer salio de la lista: si bloqueaba a las de atras, ahora pueden cubrirse con lo disponible
+        if (result == OS_TIMEOUT) semaphoreHandOut(semaphore);
     }
 
     osExitCriticalSection(); // Sale de la sección crítica
-    return true;             // Devuelve true indicando que el semáforo se tomó con éxito
+    return result;
 }
 
 // Libera el semáforo
-void osSemaphoreGive(osSemaphoreObject* semaphore){
-    osEnterCriticalSection(); // Entra en la sección crítica
+bool osSemaphoreGive(osSemaphoreObject* semaphore){
+    return osSemaphoreGiveN(semaphore, 1);
+}
 
-    semaphore->lockedFlag = false; // Marca el semáforo como liberado
+bool osSemaphoreGiveN(osSemaphoreObject* semaphore, const uint32_t count){
+    uint32_t available;
+    bool given = true;
 
-    checkBlockedTaskFromSem(semaphore); // Verifica si hay tareas bloqueadas esperando el semáforo
+    /**
+     * Camino rapido sin tareas esperando: un solo incremento atomico. Si entre LDREX y STREX una tarea se
+     * bloquea en el semaforo hubo una excepcion, que limpia el monitor exclusivo y hace fallar STREX.
+     */
+    while (1)
+    {
+        available = __LDREXW(&semaphore->count);
+        if (semaphore->waitList.head != NULL || semaphore->set != NULL)
+        {
+            __CLREX();
+            break;      // Hay tareas esperando (en el semaforo o en su conjunto): camino lento
+        }
+        if (available + count > semaphore->maxCount || available + count < available)
+        {
+            __CLREX();
+            return false;
+        }
+        if (__STREXW(available + count, &semaphore->count) == 0) return true;
+    }
+
+    osEnterCriticalSection(); // Entra en la sección crítica
+
+    if (semaphore->count + count > semaphore->maxCount || semaphore->count + count < semaphore->count)
+    {
+        given = false;
+    }
+    else
+    {
+        semaphore->count += count;
+        semaphoreHandOut(semaphore);
+    }
 
     osExitCriticalSection(); // Sale de la sección crítica
+    return given;
+}
+
+static bool semaphoreCanTake(osSemaphoreObject* semaphore, const uint32_t count){
+    osTaskObject* head = semaphore->waitList.head;
+    osTaskObject* task;
+
+    if (semaphore->count < count) return false;
+    if (head == NULL) return true;
+
+    // Por prioridad la tarea actual quedaria delante de las de menor prioridad: no se adelanta a nadie
+    task = osGetRunningTask();
+    return semaphore->waitList.order == OS_WAIT_PRIORITY && task != NULL && task->taskPriority < head->taskPriority;
+}
+
+static void semaphoreHandOut(osSemaphoreObject* semaphore){
+    // Despierta en orden a las tareas cuyo pedido ya se puede cubrir
+    while (semaphore->waitList.head != NULL && semaphore->waitList.head->taskWaitValue <= semaphore->count)
+    {
+        semaphore->count -= semaphore->waitList.head->taskWaitValue;
+        checkBlockedTaskFromSem(semaphore);
+    }
+
+    // Lo que no se llevaron las que esperaban el semaforo lo puede tomar quien espera el conjunto
+    if (semaphore->count > 0 && semaphore->set != NULL) checkBlockedTaskFromQueueSet(semaphore->set);
 }
@@ -0,0 +1,103 @@
+/*
+ * osStreamBuffer.c
+ *
+ * Flujo de bytes con nivel de disparo sobre el anillo sin bloqueos de osRing.
+ */
+#include <osStreamBuffer.h>
+#include "osKernel.h"
+
+bool osStreamBufferInit(osStreamBufferObject* stream, void* buffer, const uint32_t size, const uint32_t triggerLevel){
+    if (triggerLevel == 0 || triggerLevel > size || !osRingInit(&stream->ring, buffer, size, 1)) return false;
+
+    stream->triggerLevel = triggerLevel;
+    stream->readerTrigger = triggerLevel;
+    stream->reader = NULL;
+    stream->writer = NULL;
+    return true;
+}
+
+uint32_t osStreamBufferWrite(osStreamBufferObject* stream, const void* data, const uint32_t length, const uint32_t timeout){
+    const uint32_t startTick = osGetTickCount();
+    const uint8_t* bytes = data;
+    uint32_t written = 0;
+    struct osTaskObject* reader;
+
+    while (1)
+    {
+        written += osRingPush(&stream->ring, bytes + written, length - written);
+
+        // Despierta al lector solo al alcanzar su nivel: una ISR que escribe byte a byte no lo despierta cada vez
+        reader = stream->reader;
+        if (reader != NULL && osRingCount(&stream->ring) >= stream->readerTrigger)
+        {
+            osTaskNotify(reader, 0, OS_NOTIFY_NO_ACTION);
+        }
+
+        if (written == length) break;
+
+        uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+        osTaskObject* task = osGetRunningTask();
+        if (remaining == 0 || task == NULL) break;
+
+        // Igual que el lector: se anota, vuelve a mirar y recien entonces espera
+        stream->writer = task;
+        __DMB();
+        if (osRingCount(&stream->ring) == stream->ring.capacity && osTaskNotifyWait(0, 0, NULL, remaining) != OS_OK)
+        {
+            stream->writer = NULL;
+            break;
+        }
+        stream->writer = NULL;
+    }
+
+    return written;
+}
+
+uint32_t osStreamBufferRead(osStreamBufferObject* stream, void* data, const uint32_t length, const uint32_t timeout){
+    const uint32_t startTick = osGetTickCount();
+    const uint32_t trigger = (length < stream->triggerLevel) ? length : stream->triggerLevel;
+    uint32_t n;
+    struct osTaskObject* writer;
+
+    while (osRingCount(&stream->ring) < trigger)
+    {
+        uint32_t remaining = osGetRemainingTicks(startTick, timeout);
+        osTaskObject* task = osGetRunningTask();
+
+        // Desde un handler no se puede esperar
+        if (remaining == 0 || task == NULL) break;
+
+        /**
+         * Se anota como lectora y vuelve a mirar: si el escritor llego al nivel antes de verla, lo encuentra
+         * aca; si llego despues, la notifico y la espera retorna enseguida.
+         */
+        stream->readerTrigger = trigger;
+        stream->reader = task;
+        __DMB();
+        if (osRingCount(&stream->ring) < trigger && osTaskNotifyWait(0, 0, NULL, remaining) != OS_OK)
+        {
+            stream->reader = NULL;
+            break;
+        }
+        stream->reader = NULL;
+    }
+
+    // Al vencer el timeout se entrega lo que haya, aunque no llegue al nivel
+    n = osRingPop(&stream->ring, data, length);
+
+    writer = stream->writer;
+    if (n > 0 && writer != NULL) osTaskNotify(writer, 0, OS_NOTIFY_NO_ACTION);
+
+    return n;
+}
+
+bool osStreamBufferSetTriggerLevel(osStreamBufferObject* stream, const uint32_t triggerLevel){
+    if (triggerLevel == 0 || triggerLevel > stream->ring.capacity) return false;
+
+    stream->triggerLevel = triggerLevel;
+    return true;
+}
+
+uint32_t osStreamBufferAvailable(osStreamBufferObject* stream){
+    return osRingCount(&stream->ring);
+}
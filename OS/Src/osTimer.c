@@ -0,0 +1,171 @@
+/*
+ * osTimer.c
+ *
+ * Timers por software: una sola tarea ejecuta los callbacks de todos los timers, en orden de vencimiento.
+ */
+#include <osTimer.h>
+#include "osKernel.h"
+
+static osTaskObject timerTask;
+static uint32_t timerStack[OS_TIMER_STACK_SIZE/4] OS_STACK_ALIGN;
+static osTimerObject* timerList = NULL;     // Timers activos, la cabeza es el proximo en vencer
+
+/**
+ * @brief Tarea de timers: duerme hasta el vencimiento mas cercano y ejecuta los callbacks vencidos.
+ */
+static void timerTaskHandler(void);
+/**
+ * @brief Agrega un timer a la lista de vencimientos respetando el orden por expiryTick.
+ * @return true si quedo primero (la tarea de timers tiene que recalcular su espera).
+ */
+static bool timerListInsert(osTimerObject* timer);
+/**
+ * @brief Quita un timer de la lista de vencimientos.
+ */
+static void timerListRemove(osTimerObject* timer);
+
+
+void osTimerInit(osTimerObject* timer, osTimerCallback callback, void* data, const uint32_t period, const bool autoReload){
+    timer->callback = callback;
+    timer->data = data;
+    timer->period = period;
+    timer->expiryTick = 0;
+    timer->autoReload = autoReload;
+    timer->active = false;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+bool osTimerStart(osTimerObject* timer){
+    bool first = false;
+
+    if (timer->callback == NULL || timer->period == 0 || timer->period > OS_MAX_TIMEOUT) return false;
+
+    osEnterCriticalSection();
+
+    if (!timer->active)
+    {
+        timer->expiryTick = osGetTickCount() + timer->period;
+        first = timerListInsert(timer);
+    }
+
+    osExitCriticalSection();
+
+    // Vence antes de lo que la tarea de timers esta esperando: se la despierta para que recalcule
+    if (first) osTaskNotify(&timerTask, 0, OS_NOTIFY_NO_ACTION);
+    return true;
+}
+
+bool osTimerReset(osTimerObject* timer){
+    bool first;
+
+    if (timer->callback == NULL || timer->period == 0 || timer->period > OS_MAX_TIMEOUT) return false;
+
+    osEnterCriticalSection();
+
+    if (timer->active) timerListRemove(timer);
+    timer->expiryTick = osGetTickCount() + timer->period;
+    first = timerListInsert(timer);
+
+    osExitCriticalSection();
+
+    if (first) osTaskNotify(&timerTask, 0, OS_NOTIFY_NO_ACTION);
+    return true;
+}
+
+void osTimerStop(osTimerObject* timer){
+    osEnterCriticalSection();
+
+    // Si era la cabeza la tarea de timers despierta antes de tiempo y vuelve a dormir: no hace falta avisarle
+    if (timer->active) timerListRemove(timer);
+
+    osExitCriticalSection();
+}
+
+bool osTimerSetPeriod(osTimerObject* timer, const uint32_t period){
+    // Los vencimientos se ordenan con resta con signo: un periodo mayor se veria vencido
+    if (period == 0 || period > OS_MAX_TIMEOUT) return false;
+
+    timer->period = period;
+    return true;
+}
+
+bool osTimerIsActive(osTimerObject* timer){
+    return timer->active;
+}
+
+bool osTimerServiceInit(void){
+    return osTaskCreateEx(&timerTask, OS_TIMER_TASK_PRIORITY, timerTaskHandler, timerStack, OS_TIMER_STACK_SIZE, OS_TASK_FLAG_NONE);
+}
+
+static void timerTaskHandler(void){
+    osTimerObject* timer;
+    uint32_t now, wakeTick;
+    bool pending;
+
+    while (1)
+    {
+        osEnterCriticalSection();
+
+        now = osGetTickCount();
+        while ((timer = timerList) != NULL && (int32_t)(now - timer->expiryTick) >= 0)
+        {
+            timerListRemove(timer);
+
+            // El periodico se rearma desde su vencimiento, no desde ahora: no acumula el atraso del callback
+            if (timer->autoReload)
+            {
+                timer->expiryTick += timer->period;
+                timerListInsert(timer);
+            }
+
+            // El callback corre con las interrupciones habilitadas y puede arrancar o detener timers
+            osExitCriticalSection();
+            timer->callback(timer->data);
+            osEnterCriticalSection();
+        }
+
+        pending = (timerList != NULL);
+        wakeTick = pending ? timerList->expiryTick : 0;
+
+        osExitCriticalSection();
+
+        /**
+         * Duerme en la lista de dormidas del kernel (compatible con tickless) o hasta que un start/reset la
+         * avise. Se espera el tick absoluto de la cabeza: un tick que pase antes de bloquearse no atrasa
+         * el vencimiento.
+         */
+        if (pending) osTaskNotifyWaitUntil(0, 0, NULL, wakeTick);
+        else         osTaskNotifyWait(0, 0, NULL, OS_MAX_DELAY);
+    }
+}
+
+static bool timerListInsert(osTimerObject* timer){
+    osTimerObject* prev = NULL;
+    osTimerObject* next = timerList;
+
+    // La resta con signo tolera el desborde del contador de ticks; entre iguales, FIFO
+    while (next != NULL && (int32_t)(next->expiryTick - timer->expiryTick) <= 0)
+    {
+        prev = next;
+        next = next->next;
+    }
+
+    timer->prev = prev;
+    timer->next = next;
+    if (prev != NULL) prev->next = timer;
+    else              timerList = timer;
+    if (next != NULL) next->prev = timer;
+    timer->active = true;
+
+    return prev == NULL;
+}
+
+static void timerListRemove(osTimerObject* timer){
+    if (timer->prev != NULL) timer->prev->next = timer->next;
+    else                     timerList = timer->next;
+    if (timer->next != NULL) timer->next->prev = timer->prev;
+    timer->next = NULL;
+    timer->prev = NULL;
+    timer->active = false;
+}